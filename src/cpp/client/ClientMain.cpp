@@ -2,20 +2,150 @@
 #include <grpcpp/grpcpp.h>
 #include "minitwo.grpc.pb.h"
 #include "../common/config.h"
+#include "../common/ColumnBatch.h"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <thread>
 #include <vector>
+#include <deque>
+#include <future>
+#include <algorithm>
+#include <cctype>
 
 // Helper to create channel with increased message size limits (1.5GB for very large datasets)
-std::shared_ptr<grpc::Channel> CreateChannelWithLimits(const std::string& target) {
+// Channels normally share one connection per target; `own_connection` gives
+// this channel its own so parallel fetches don't queue behind each other
+std::shared_ptr<grpc::Channel> CreateChannelWithLimits(const std::string& target,
+                                                       bool own_connection = false) {
     grpc::ChannelArguments args;
     args.SetMaxReceiveMessageSize(1536 * 1024 * 1024); // 1.5GB
     args.SetMaxSendMessageSize(1536 * 1024 * 1024);    // 1.5GB
+    if (own_connection) {
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    }
     return grpc::CreateCustomChannel(target, grpc::InsecureChannelCredentials(), args);
 }
 
+// Per-request query options from the command line, copied into every Request
+struct QueryOptions {
+    std::vector<mini2::Predicate> filters;  // --where, pushed down to the workers
+    std::vector<std::string> columns;       // --columns, projection applied by the workers
+    mini2::Aggregation aggregate;           // --agg / --group-by, computed in the tree
+    mini2::Request::PayloadFormat format = mini2::Request::CSV;  // --format
+    uint32_t part_bytes = 0;                // --part-bytes, 0 = server default
+};
+
+void ApplyQueryOptions(const QueryOptions& options, mini2::Request* req) {
+    for (const auto& pred : options.filters) {
+        *req->add_filters() = pred;
+    }
+    for (const auto& column : options.columns) {
+        req->add_columns(column);
+    }
+    if (options.aggregate.measures_size() > 0 || options.aggregate.group_by_size() > 0) {
+        *req->mutable_aggregate() = options.aggregate;
+    }
+    req->set_format(options.format);
+    req->set_part_bytes(options.part_bytes);
+}
+
+// Rows in one result chunk, decoding it if it is a binary batch
+size_t CountRows(const std::string& chunk) {
+    if (colbatch::IsColumnBatch(chunk)) {
+        colbatch::Reader reader;
+        std::string error;
+        if (!reader.Parse(chunk, &error)) {
+            std::cerr << "  ✗ Bad columnar chunk: " << error << std::endl;
+            return 0;
+        }
+        return reader.NumRows();
+    }
+    size_t lines = std::count(chunk.begin(), chunk.end(), '\n');
+    return lines > 0 ? lines - 1 : 0;  // minus the header
+}
+
+std::string Trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t");
+    size_t e = s.find_last_not_of(" \t");
+    return (b == std::string::npos) ? "" : s.substr(b, e - b + 1);
+}
+
+std::vector<std::string> SplitOn(const std::string& s, const std::string& sep) {
+    std::vector<std::string> parts;
+    size_t start = 0, pos;
+    while ((pos = s.find(sep, start)) != std::string::npos) {
+        parts.push_back(Trim(s.substr(start, pos - start)));
+        start = pos + sep.size();
+    }
+    parts.push_back(Trim(s.substr(start)));
+    return parts;
+}
+
+// Parses "Column<op>value" (op: = != < <= > >=), "Column in a|b|c" or
+// "Column between lo..hi". Column names may contain spaces ("Site Name=...").
+bool ParsePredicate(const std::string& text, mini2::Predicate* pred) {
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    size_t kw;
+    if ((kw = lower.find(" between ")) != std::string::npos) {
+        auto bounds = SplitOn(text.substr(kw + 9), "..");
+        if (bounds.size() != 2) return false;
+        pred->set_column(Trim(text.substr(0, kw)));
+        pred->set_op(mini2::Predicate::BETWEEN);
+        for (const auto& b : bounds) pred->add_values(b);
+        return !pred->column().empty();
+    }
+    if ((kw = lower.find(" in ")) != std::string::npos) {
+        pred->set_column(Trim(text.substr(0, kw)));
+        pred->set_op(mini2::Predicate::IN);
+        for (const auto& v : SplitOn(text.substr(kw + 4), "|")) pred->add_values(v);
+        return !pred->column().empty();
+    }
+
+    size_t pos = text.find_first_of("!<>=");
+    if (pos == std::string::npos || pos == 0) return false;
+    std::string op = text.substr(pos, (pos + 1 < text.size() && text[pos + 1] == '=') ? 2 : 1);
+
+    if (op == "=" || op == "==") pred->set_op(mini2::Predicate::EQ);
+    else if (op == "!=") pred->set_op(mini2::Predicate::NE);
+    else if (op == "<") pred->set_op(mini2::Predicate::LT);
+    else if (op == "<=") pred->set_op(mini2::Predicate::LE);
+    else if (op == ">") pred->set_op(mini2::Predicate::GT);
+    else if (op == ">=") pred->set_op(mini2::Predicate::GE);
+    else return false;
+
+    pred->set_column(Trim(text.substr(0, pos)));
+    pred->add_values(Trim(text.substr(pos + op.size())));
+    return true;
+}
+
+// Parses "count", "sum(Col)", "min(Col)", "max(Col)" or "avg(Col)"
+bool ParseMeasure(const std::string& text, mini2::Aggregation::Measure* measure) {
+    std::string t = Trim(text);
+    size_t open = t.find('(');
+    std::string func = t.substr(0, open);
+    std::transform(func.begin(), func.end(), func.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (func == "count") measure->set_func(mini2::Aggregation::COUNT);
+    else if (func == "sum") measure->set_func(mini2::Aggregation::SUM);
+    else if (func == "min") measure->set_func(mini2::Aggregation::MIN);
+    else if (func == "max") measure->set_func(mini2::Aggregation::MAX);
+    else if (func == "avg") measure->set_func(mini2::Aggregation::AVG);
+    else return false;
+
+    if (open == std::string::npos) {
+        return measure->func() == mini2::Aggregation::COUNT;
+    }
+    size_t close = t.rfind(')');
+    if (close == std::string::npos || close < open) return false;
+    measure->set_column(Trim(t.substr(open + 1, close - open - 1)));
+    return measure->func() == mini2::Aggregation::COUNT || !measure->column().empty();
+}
+
 void testPing(const std::string& target) {
     auto channel = CreateChannelWithLimits(target);
     std::unique_ptr<mini2::NodeControl::Stub> stub = mini2::NodeControl::NewStub(channel);
@@ -66,7 +196,8 @@ void testOpenSession(const std::string& target) {
 }
 
 // Strategy B: GetNext (sequential pull)
-void testStrategyB_GetNext(const std::string& gateway, const std::string& dataset_path = "") {
+void testStrategyB_GetNext(const std::string& gateway, const std::string& dataset_path = "",
+                           const QueryOptions& options = QueryOptions()) {
     std::cout << "\n========================================" << std::endl;
     std::cout << "Testing Strategy B: GetNext (Sequential)" << std::endl;
     std::cout << "========================================\n" << std::endl;
@@ -85,6 +216,7 @@ void testStrategyB_GetNext(const std::string& gateway, const std::string& datase
     req.set_query(dataset_path);
     req.set_need_green(true);
     req.set_need_pink(true);
+    ApplyQueryOptions(options, &req);
     
     mini2::SessionOpen session;
     auto start_session = std::chrono::high_resolution_clock::now();
@@ -105,6 +237,8 @@ void testStrategyB_GetNext(const std::string& gateway, const std::string& datase
     std::cout << "Step 2: Retrieving chunks sequentially..." << std::endl;
     uint32_t index = 0;
     uint64_t total_bytes = 0;
+    uint64_t total_rows = 0;
+    std::string error;  // from the final response: the result is not complete
     auto start_chunks = std::chrono::high_resolution_clock::now();
     auto first_chunk_time = std::chrono::high_resolution_clock::time_point();
     
@@ -130,6 +264,9 @@ void testStrategyB_GetNext(const std::string& gateway, const std::string& datase
             std::cerr << "✗ GetNext failed: " << status.error_message() << std::endl;
             break;
         }
+        if (!resp.error().empty()) {
+            error = resp.error();
+        }
         
         if (!resp.has_more() && resp.chunk().empty()) {
             std::cout << "No more chunks available" << std::endl;
@@ -137,6 +274,7 @@ void testStrategyB_GetNext(const std::string& gateway, const std::string& datase
         }
         
         total_bytes += resp.chunk().size();
+        total_rows += CountRows(resp.chunk());
         auto chunk_latency = std::chrono::duration_cast<std::chrono::milliseconds>(end_chunk - start_chunk);
         
         std::cout << "  ✓ Chunk " << index 
@@ -160,14 +298,162 @@ void testStrategyB_GetNext(const std::string& gateway, const std::string& datase
     std::cout << "========================================" << std::endl;
     std::cout << "Total chunks: " << index << std::endl;
     std::cout << "Total bytes: " << total_bytes << std::endl;
+    std::cout << "Total rows: " << total_rows << std::endl;
+    if (!error.empty()) {
+        std::cout << "✗ Result incomplete: " << error << std::endl;
+    }
     std::cout << "Time to first chunk: " << time_to_first_chunk.count() << " ms ⚡" << std::endl;
     std::cout << "Total time: " << total_time.count() << " ms" << std::endl;
     std::cout << "RPC calls made: " << (1 + index) << " (1 StartRequest + " << index << " GetNext)" << std::endl;
     std::cout << "========================================\n" << std::endl;
 }
 
+// Strategy B: GetNext with a window of requests in flight. Chunk i+window is
+// requested as soon as chunk i has been consumed, so the round trip for later
+// chunks overlaps with the transfer of earlier ones; requests are spread over
+// `channels` connections and the replies are consumed in index order.
+void testStrategyB_Prefetch(const std::string& gateway, const std::string& dataset_path = "",
+                            const QueryOptions& options = QueryOptions(),
+                            uint32_t window = 4, int channels = 1) {
+    window = std::max<uint32_t>(1, window);
+    channels = std::max(1, channels);
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Testing Strategy B: GetNext (Prefetch, window=" << window 
+              << ", channels=" << channels << ")" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+    
+    std::vector<std::unique_ptr<mini2::ClientGateway::Stub>> stubs;
+    for (int c = 0; c < channels; ++c) {
+        stubs.push_back(mini2::ClientGateway::NewStub(CreateChannelWithLimits(gateway, channels > 1)));
+    }
+    
+    // Start request
+    std::cout << "Step 1: Starting session..." << std::endl;
+    grpc::ClientContext ctx1;
+    ctx1.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(30));
+    
+    mini2::Request req;
+    req.set_request_id("test-strategyB-prefetch");
+    req.set_query(dataset_path);
+    req.set_need_green(true);
+    req.set_need_pink(true);
+    ApplyQueryOptions(options, &req);
+    
+    mini2::SessionOpen session;
+    auto start_session = std::chrono::high_resolution_clock::now();
+    auto status = stubs[0]->StartRequest(&ctx1, req, &session);
+    auto end_session = std::chrono::high_resolution_clock::now();
+    auto session_latency = std::chrono::duration_cast<std::chrono::milliseconds>(end_session - start_session);
+    
+    if (!status.ok()) {
+        std::cerr << "FAILED: StartRequest - " << status.error_message() << std::endl;
+        return;
+    }
+    
+    std::cout << "Session started: " << session.request_id() << std::endl;
+    std::cout << "  Session creation time: " << session_latency.count() << " ms" << std::endl;
+    std::cout << std::endl;
+    
+    struct Fetch {
+        grpc::Status status;
+        mini2::NextChunkResp resp;
+        std::chrono::high_resolution_clock::time_point start, end;
+    };
+    // Each fetch is a blocking call on its own thread; the stubs are thread-safe
+    auto fetch = [&stubs, &session, window](uint32_t index) {
+        Fetch f;
+        grpc::ClientContext ctx;
+        ctx.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(600));
+        mini2::NextChunkReq next_req;
+        next_req.set_request_id(session.request_id());
+        next_req.set_next_index(index);
+        next_req.set_window(window);
+        f.start = std::chrono::high_resolution_clock::now();
+        f.status = stubs[index % stubs.size()]->GetNext(&ctx, next_req, &f.resp);
+        f.end = std::chrono::high_resolution_clock::now();
+        return f;
+    };
+    
+    std::cout << "Step 2: Retrieving chunks with " << window << " request(s) in flight..." << std::endl;
+    std::deque<std::future<Fetch>> in_flight;
+    uint32_t next_request = 0;
+    auto top_up = [&]() {
+        while (in_flight.size() < window) {
+            in_flight.push_back(std::async(std::launch::async, fetch, next_request++));
+        }
+    };
+    
+    uint32_t index = 0;
+    uint64_t total_bytes = 0;
+    uint64_t total_rows = 0;
+    std::string error;
+    auto first_chunk_time = std::chrono::high_resolution_clock::time_point();
+    
+    top_up();
+    while (true) {
+        Fetch f = in_flight.front().get();
+        in_flight.pop_front();
+        
+        if (index == 0) {
+            first_chunk_time = f.end;
+        }
+        
+        if (!f.status.ok()) {
+            std::cerr << "✗ GetNext failed: " << f.status.error_message() << std::endl;
+            break;
+        }
+        if (!f.resp.error().empty()) {
+            error = f.resp.error();
+        }
+        
+        if (!f.resp.has_more() && f.resp.chunk().empty()) {
+            std::cout << "No more chunks available" << std::endl;
+            break;
+        }
+        
+        total_bytes += f.resp.chunk().size();
+        total_rows += CountRows(f.resp.chunk());
+        auto chunk_latency = std::chrono::duration_cast<std::chrono::milliseconds>(f.end - f.start);
+        
+        std::cout << "  ✓ Chunk " << index 
+                  << ": " << f.resp.chunk().size() << " bytes"
+                  << " (latency: " << chunk_latency.count() << " ms)"
+                  << " (has_more: " << (f.resp.has_more() ? "yes" : "no") << ")" << std::endl;
+        
+        index++;
+        
+        if (!f.resp.has_more()) {
+            break;
+        }
+        top_up();
+    }
+    
+    // Requests past the end return once the session completes
+    in_flight.clear();
+    
+    auto end_chunks = std::chrono::high_resolution_clock::now();
+    auto total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_chunks - start_session);
+    auto time_to_first_chunk = std::chrono::duration_cast<std::chrono::milliseconds>(first_chunk_time - start_session);
+    
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Strategy B (Prefetch) Results:" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "Total chunks: " << index << std::endl;
+    std::cout << "Total bytes: " << total_bytes << std::endl;
+    std::cout << "Total rows: " << total_rows << std::endl;
+    if (!error.empty()) {
+        std::cout << "✗ Result incomplete: " << error << std::endl;
+    }
+    std::cout << "Time to first chunk: " << time_to_first_chunk.count() << " ms ⚡" << std::endl;
+    std::cout << "Total time: " << total_time.count() << " ms" << std::endl;
+    std::cout << "RPC calls made: " << (1 + next_request) << " (1 StartRequest + " << next_request 
+              << " GetNext, " << (next_request - index) << " past the end)" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
 // Strategy B: PollNext (polling)
-void testStrategyB_PollNext(const std::string& gateway, const std::string& dataset_path = "") {
+void testStrategyB_PollNext(const std::string& gateway, const std::string& dataset_path = "",
+                            const QueryOptions& options = QueryOptions()) {
     std::cout << "\n========================================" << std::endl;
     std::cout << "Testing Strategy B: PollNext (Polling)" << std::endl;
     std::cout << "========================================\n" << std::endl;
@@ -183,6 +469,7 @@ void testStrategyB_PollNext(const std::string& gateway, const std::string& datas
     req.set_query(dataset_path);
     req.set_need_green(true);
     req.set_need_pink(true);
+    ApplyQueryOptions(options, &req);
     
     mini2::SessionOpen session;
     auto start_session = std::chrono::high_resolution_clock::now();
@@ -200,6 +487,8 @@ void testStrategyB_PollNext(const std::string& gateway, const std::string& datas
     std::cout << "Step 2: Polling for chunks..." << std::endl;
     int chunks_received = 0;
     uint64_t total_bytes = 0;
+    uint64_t total_rows = 0;
+    std::string error;
     int poll_count = 0;
     auto first_chunk_time = std::chrono::high_resolution_clock::time_point();
     
@@ -216,6 +505,9 @@ void testStrategyB_PollNext(const std::string& gateway, const std::string& datas
             std::cerr << "✗ PollNext failed: " << status.error_message() << std::endl;
             break;
         }
+        if (!resp.error().empty()) {
+            error = resp.error();
+        }
         
         if (resp.ready()) {
             if (chunks_received == 0) {
@@ -223,6 +515,7 @@ void testStrategyB_PollNext(const std::string& gateway, const std::string& datas
             }
             
             total_bytes += resp.chunk().size();
+            total_rows += CountRows(resp.chunk());
             chunks_received++;
             
             std::cout << "  ✓ Chunk " << chunks_received 
@@ -247,12 +540,106 @@ void testStrategyB_PollNext(const std::string& gateway, const std::string& datas
     std::cout << "========================================" << std::endl;
     std::cout << "Total chunks: " << chunks_received << std::endl;
     std::cout << "Total bytes: " << total_bytes << std::endl;
+    std::cout << "Total rows: " << total_rows << std::endl;
+    if (!error.empty()) {
+        std::cout << "✗ Result incomplete: " << error << std::endl;
+    }
     std::cout << "Time to first chunk: " << time_to_first_chunk.count() << " ms ⚡" << std::endl;
     std::cout << "Total time: " << total_time.count() << " ms" << std::endl;
     std::cout << "RPC calls made: " << (1 + poll_count) << " (1 StartRequest + " << poll_count << " PollNext)" << std::endl;
     std::cout << "========================================\n" << std::endl;
 }
 
+// Strategy B: StreamChunks (server push, one RPC for all chunks)
+void testStrategyB_Stream(const std::string& gateway, const std::string& dataset_path = "",
+                          const QueryOptions& options = QueryOptions()) {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Testing Strategy B: StreamChunks (Push)" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+    
+    auto channel = CreateChannelWithLimits(gateway);
+    std::unique_ptr<mini2::ClientGateway::Stub> stub = mini2::ClientGateway::NewStub(channel);
+    
+    // Start request
+    std::cout << "Step 1: Starting session..." << std::endl;
+    grpc::ClientContext ctx1;
+    ctx1.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(30));
+    mini2::Request req;
+    req.set_request_id("test-strategyB-stream");
+    req.set_query(dataset_path);
+    req.set_need_green(true);
+    req.set_need_pink(true);
+    ApplyQueryOptions(options, &req);
+    
+    mini2::SessionOpen session;
+    auto start_session = std::chrono::high_resolution_clock::now();
+    auto status = stub->StartRequest(&ctx1, req, &session);
+    
+    if (!status.ok()) {
+        std::cerr << "✗ StartRequest failed: " << status.error_message() << std::endl;
+        return;
+    }
+    
+    std::cout << "✓ Session started: " << session.request_id() << std::endl;
+    std::cout << std::endl;
+    
+    // One streaming call; chunks arrive as the leader receives them
+    std::cout << "Step 2: Streaming chunks..." << std::endl;
+    grpc::ClientContext ctx2;
+    ctx2.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(600));
+    mini2::NextChunkReq stream_req;
+    stream_req.set_request_id(session.request_id());
+    stream_req.set_next_index(0);
+    
+    uint32_t chunks_received = 0;
+    uint64_t total_bytes = 0;
+    uint64_t total_rows = 0;
+    std::string error;
+    auto first_chunk_time = std::chrono::high_resolution_clock::time_point();
+    
+    auto reader = stub->StreamChunks(&ctx2, stream_req);
+    mini2::NextChunkResp resp;
+    while (reader->Read(&resp)) {
+        if (chunks_received == 0) {
+            first_chunk_time = std::chrono::high_resolution_clock::now();
+        }
+        if (!resp.error().empty()) {
+            error = resp.error();
+        }
+        total_bytes += resp.chunk().size();
+        total_rows += CountRows(resp.chunk());
+        
+        std::cout << "  ✓ Chunk " << chunks_received 
+                  << ": " << resp.chunk().size() << " bytes"
+                  << " (has_more: " << (resp.has_more() ? "yes" : "no") << ")" << std::endl;
+        chunks_received++;
+    }
+    status = reader->Finish();
+    if (!status.ok()) {
+        std::cerr << "✗ StreamChunks failed: " << status.error_message() << std::endl;
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto total_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_session);
+    auto time_to_first_chunk = std::chrono::duration_cast<std::chrono::milliseconds>(first_chunk_time - start_session);
+    
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "Strategy B (StreamChunks) Results:" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << "Total chunks: " << chunks_received << std::endl;
+    std::cout << "Total bytes: " << total_bytes << std::endl;
+    std::cout << "Total rows: " << total_rows << std::endl;
+    if (!error.empty()) {
+        std::cout << "✗ Result incomplete: " << error << std::endl;
+    }
+    if (chunks_received > 0) {
+        std::cout << "Time to first chunk: " << time_to_first_chunk.count() << " ms ⚡" << std::endl;
+    }
+    std::cout << "Total time: " << total_time.count() << " ms" << std::endl;
+    std::cout << "RPC calls made: 2 (1 StartRequest + 1 StreamChunks)" << std::endl;
+    std::cout << "========================================\n" << std::endl;
+}
+
 int main(int argc, char** argv){
     // Load network configuration - try multiple paths
     std::string gateway = "localhost:50050";
@@ -283,6 +670,9 @@ int main(int argc, char** argv){
     
     std::string mode = "session";
     std::string dataset_path = "";  // Dataset path for query field
+    QueryOptions options;
+    uint32_t window = 4;    // --window, GetNext requests in flight (strategy-b-prefetch)
+    int channels = 1;       // --channels, connections to spread them over
     
     for (int i=1;i<argc;i++){
         std::string a = argv[i];
@@ -290,6 +680,42 @@ int main(int argc, char** argv){
         else if (a=="--mode" && i+1<argc) mode = argv[++i];
         else if (a=="--dataset" && i+1<argc) dataset_path = argv[++i];
         else if (a=="--query" && i+1<argc) dataset_path = argv[++i];  // Accept --query as alias
+        else if (a=="--where" && i+1<argc) {
+            mini2::Predicate pred;
+            std::string expr = argv[++i];
+            if (!ParsePredicate(expr, &pred)) {
+                std::cerr << "Bad --where expression: " << expr << std::endl;
+                return 1;
+            }
+            options.filters.push_back(pred);
+        }
+        else if (a=="--columns" && i+1<argc) options.columns = SplitOn(argv[++i], ",");
+        else if (a=="--agg" && i+1<argc) {
+            std::string spec = argv[++i];
+            for (const auto& item : SplitOn(spec, ",")) {
+                if (!ParseMeasure(item, options.aggregate.add_measures())) {
+                    std::cerr << "Bad --agg measure: " << item << std::endl;
+                    return 1;
+                }
+            }
+        }
+        else if (a=="--format" && i+1<argc) {
+            std::string format = argv[++i];
+            if (format == "columnar") options.format = mini2::Request::COLUMNAR;
+            else if (format == "csv") options.format = mini2::Request::CSV;
+            else {
+                std::cerr << "Unknown --format: " << format << " (csv|columnar)" << std::endl;
+                return 1;
+            }
+        }
+        else if (a=="--part-bytes" && i+1<argc) options.part_bytes = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (a=="--window" && i+1<argc) window = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (a=="--channels" && i+1<argc) channels = std::stoi(argv[++i]);
+        else if (a=="--group-by" && i+1<argc) {
+            for (const auto& column : SplitOn(argv[++i], ",")) {
+                options.aggregate.add_group_by(column);
+            }
+        }
     }
     
     std::cout << "=== Mini2 Client ===" << std::endl;
@@ -298,6 +724,22 @@ int main(int argc, char** argv){
     if (!dataset_path.empty()) {
         std::cout << "Dataset: " << dataset_path << std::endl;
     }
+    if (!options.filters.empty()) {
+        std::cout << "Filters: " << options.filters.size() << " predicate(s)" << std::endl;
+    }
+    if (!options.columns.empty()) {
+        std::cout << "Columns: " << options.columns.size() << " selected" << std::endl;
+    }
+    if (options.format == mini2::Request::COLUMNAR) {
+        std::cout << "Format: columnar" << std::endl;
+    }
+    if (options.aggregate.group_by_size() > 0 && options.aggregate.measures_size() == 0) {
+        options.aggregate.add_measures()->set_func(mini2::Aggregation::COUNT);
+    }
+    if (options.aggregate.measures_size() > 0) {
+        std::cout << "Aggregate: " << options.aggregate.measures_size() << " measure(s), "
+                  << options.aggregate.group_by_size() << " group-by column(s)" << std::endl;
+    }
     std::cout << std::endl;
     
     if (mode == "ping") {
@@ -309,7 +751,7 @@ int main(int argc, char** argv){
         } else {
             std::cout << "📦 PROCESSING DATASET: " << dataset_path << std::endl;
             std::cout << "Using Strategy B: GetNext (Sequential chunk retrieval)" << std::endl;
-            testStrategyB_GetNext(gateway, dataset_path);
+            testStrategyB_GetNext(gateway, dataset_path, options);
         }
     } else if (mode == "all") {
         // Test all 6 processes using config addresses
@@ -340,10 +782,16 @@ int main(int argc, char** argv){
         }
     } else if (mode == "strategy-b-getnext") {
         // Test Phase 3: Strategy B with GetNext
-        testStrategyB_GetNext(gateway, dataset_path);
+        testStrategyB_GetNext(gateway, dataset_path, options);
+    } else if (mode == "strategy-b-prefetch") {
+        // Strategy B with a window of GetNext calls in flight
+        testStrategyB_Prefetch(gateway, dataset_path, options, window, channels);
     } else if (mode == "strategy-b-pollnext") {
         // Test Phase 3: Strategy B with PollNext
-        testStrategyB_PollNext(gateway, dataset_path);
+        testStrategyB_PollNext(gateway, dataset_path, options);
+    } else if (mode == "strategy-b-stream") {
+        // Strategy B with server-streaming delivery
+        testStrategyB_Stream(gateway, dataset_path, options);
     } else if (mode == "phase3") {
         // Test Phase 3: Compare all strategies
         std::cout << "\n############################################" << std::endl;
@@ -356,15 +804,21 @@ int main(int argc, char** argv){
         // Strategy B: GetNext
         testStrategyB_GetNext(gateway);
         
+        // Strategy B: GetNext with prefetch
+        testStrategyB_Prefetch(gateway, "", QueryOptions(), window, channels);
+        
         // Strategy B: PollNext
         testStrategyB_PollNext(gateway);
         
+        // Strategy B: StreamChunks
+        testStrategyB_Stream(gateway);
+        
         std::cout << "\n############################################" << std::endl;
         std::cout << "### Phase 3 Testing Complete! ###" << std::endl;
         std::cout << "############################################\n" << std::endl;
     } else {
         std::cout << "Unknown mode: " << mode << std::endl;
-        std::cout << "Available modes: ping, session, all, request, strategy-b-getnext, strategy-b-pollnext, phase3" << std::endl;
+        std::cout << "Available modes: ping, session, all, request, strategy-b-getnext, strategy-b-prefetch, strategy-b-pollnext, strategy-b-stream, phase3" << std::endl;
         return 1;
     }
     
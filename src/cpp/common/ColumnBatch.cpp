@@ -0,0 +1,407 @@
+#include "ColumnBatch.h"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+constexpr char kMagic[4] = {'M', '2', 'C', 'B'};
+constexpr uint8_t kVersion = 1;
+
+// The lab machines are all little-endian, so values are copied as-is
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void PutArray(std::string& out, const std::vector<T>& values) {
+    out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+T Load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+size_t FixedWidth(colbatch::Type type) {
+    switch (type) {
+        case colbatch::Type::Int32: return 4;
+        case colbatch::Type::Int64: return 8;
+        case colbatch::Type::Float64: return 8;
+        default: return 0;
+    }
+}
+
+// Per-row bytes in the value buffers (code or offset for the variable types)
+size_t ValueWidth(colbatch::Type type) {
+    size_t width = FixedWidth(type);
+    return width != 0 ? width : sizeof(uint32_t);
+}
+
+// Bounds-checked cursor over the serialized batch
+struct Cursor {
+    const char* p;
+    const char* end;
+
+    bool Has(size_t n) const { return static_cast<size_t>(end - p) >= n; }
+
+    template <typename T>
+    bool Read(T* value) {
+        if (!Has(sizeof(T))) return false;
+        *value = Load<T>(p);
+        p += sizeof(T);
+        return true;
+    }
+
+    bool Skip(size_t n, const char** start) {
+        if (!Has(n)) return false;
+        *start = p;
+        p += n;
+        return true;
+    }
+};
+
+bool ParseInt64(std::string_view text, int64_t* value) {
+    if (text.empty()) return false;
+    auto res = std::from_chars(text.data(), text.data() + text.size(), *value);
+    return res.ec == std::errc() && res.ptr == text.data() + text.size();
+}
+
+bool ParseFloat64(std::string_view text, double* value) {
+    char buf[64];
+    if (text.empty() || text.size() >= sizeof(buf)) return false;
+    std::memcpy(buf, text.data(), text.size());
+    buf[text.size()] = '\0';
+    char* end = nullptr;
+    *value = std::strtod(buf, &end);
+    return end == buf + text.size();
+}
+
+void AppendCsvField(std::ostringstream& out, std::string_view field) {
+    if (field.find_first_of(",\"") != std::string_view::npos) {
+        out << '"' << field << '"';
+    } else {
+        out << field;
+    }
+}
+
+}  // namespace
+
+namespace colbatch {
+
+const char* TypeName(Type type) {
+    switch (type) {
+        case Type::Int32: return "int32";
+        case Type::Int64: return "int64";
+        case Type::Float64: return "float64";
+        case Type::Dictionary: return "dictionary";
+        case Type::String: return "string";
+    }
+    return "?";
+}
+
+bool IsColumnBatch(std::string_view payload) {
+    return payload.size() >= sizeof(kMagic) && std::memcmp(payload.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+Writer::Writer(std::vector<Field> fields)
+    : fields_(std::move(fields))
+    , columns_(fields_.size()) {}
+
+void Writer::AppendRow(const std::vector<std::string_view>& values) {
+    const size_t byte = rows_ / 8;
+    const uint8_t bit = static_cast<uint8_t>(1u << (rows_ % 8));
+
+    for (size_t c = 0; c < fields_.size(); ++c) {
+        ColumnData& col = columns_[c];
+        if (col.valid.size() <= byte) {
+            col.valid.push_back(0);
+        }
+        std::string_view text = c < values.size() ? values[c] : std::string_view();
+        bool present = true;
+
+        switch (fields_[c].type) {
+            case Type::Int32: {
+                int64_t v = 0;
+                present = ParseInt64(text, &v) && v >= std::numeric_limits<int32_t>::min() &&
+                          v <= std::numeric_limits<int32_t>::max();
+                col.i32.push_back(present ? static_cast<int32_t>(v) : 0);
+                break;
+            }
+            case Type::Int64: {
+                int64_t v = 0;
+                present = ParseInt64(text, &v);
+                col.i64.push_back(present ? v : 0);
+                break;
+            }
+            case Type::Float64: {
+                double v = 0;
+                present = ParseFloat64(text, &v);
+                col.f64.push_back(present ? v : std::nan(""));
+                break;
+            }
+            case Type::Dictionary: {
+                auto it = col.code_index.find(std::string(text));
+                if (it == col.code_index.end()) {
+                    it = col.code_index.emplace(std::string(text), static_cast<uint32_t>(col.dictionary.size())).first;
+                    col.dictionary.emplace_back(text);
+                    approx_bytes_ += sizeof(uint32_t) + text.size();
+                }
+                col.codes.push_back(it->second);
+                break;
+            }
+            case Type::String:
+                col.bytes.append(text);
+                col.offsets.push_back(static_cast<uint32_t>(col.bytes.size()));
+                approx_bytes_ += text.size();
+                break;
+        }
+
+        if (present) {
+            col.valid[byte] |= bit;
+        }
+        approx_bytes_ += ValueWidth(fields_[c].type);
+    }
+    ++rows_;
+}
+
+std::string Writer::Finish() const {
+    std::string out;
+    out.reserve(SerializedSize());
+    out.append(kMagic, sizeof(kMagic));
+    Put<uint8_t>(out, kVersion);
+    Put<uint32_t>(out, static_cast<uint32_t>(fields_.size()));
+    Put<uint32_t>(out, static_cast<uint32_t>(rows_));
+
+    for (const auto& field : fields_) {
+        Put<uint16_t>(out, static_cast<uint16_t>(field.name.size()));
+        out.append(field.name);
+        Put<uint8_t>(out, static_cast<uint8_t>(field.type));
+    }
+
+    const size_t bitmap_bytes = (rows_ + 7) / 8;
+    for (size_t c = 0; c < fields_.size(); ++c) {
+        const ColumnData& col = columns_[c];
+        out.append(reinterpret_cast<const char*>(col.valid.data()), bitmap_bytes);
+
+        switch (fields_[c].type) {
+            case Type::Int32: PutArray(out, col.i32); break;
+            case Type::Int64: PutArray(out, col.i64); break;
+            case Type::Float64: PutArray(out, col.f64); break;
+            case Type::Dictionary:
+                Put<uint32_t>(out, static_cast<uint32_t>(col.dictionary.size()));
+                for (const auto& entry : col.dictionary) {
+                    Put<uint32_t>(out, static_cast<uint32_t>(entry.size()));
+                    out.append(entry);
+                }
+                PutArray(out, col.codes);
+                break;
+            case Type::String:
+                PutArray(out, col.offsets);
+                out.append(col.bytes);
+                break;
+        }
+    }
+    return out;
+}
+
+size_t Writer::SerializedSize() const {
+    size_t size = sizeof(kMagic) + sizeof(uint8_t) + 2 * sizeof(uint32_t);
+    const size_t bitmap_bytes = (rows_ + 7) / 8;
+    for (size_t c = 0; c < fields_.size(); ++c) {
+        const ColumnData& col = columns_[c];
+        size += sizeof(uint16_t) + fields_[c].name.size() + sizeof(uint8_t) + bitmap_bytes;
+        switch (fields_[c].type) {
+            case Type::Dictionary:
+                size += sizeof(uint32_t);
+                for (const auto& entry : col.dictionary) {
+                    size += sizeof(uint32_t) + entry.size();
+                }
+                size += col.codes.size() * sizeof(uint32_t);
+                break;
+            case Type::String:
+                size += col.offsets.size() * sizeof(uint32_t) + col.bytes.size();
+                break;
+            default:
+                size += rows_ * FixedWidth(fields_[c].type);
+                break;
+        }
+    }
+    return size;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+bool Reader::Parse(std::string_view data, std::string* error) {
+    auto fail = [error](const char* msg) {
+        if (error) *error = msg;
+        return false;
+    };
+
+    fields_.clear();
+    columns_.clear();
+    rows_ = 0;
+
+    if (!IsColumnBatch(data)) {
+        return fail("not a column batch");
+    }
+    Cursor cur{data.data() + sizeof(kMagic), data.data() + data.size()};
+
+    uint8_t version = 0;
+    uint32_t num_columns = 0, num_rows = 0;
+    if (!cur.Read(&version) || !cur.Read(&num_columns) || !cur.Read(&num_rows)) {
+        return fail("truncated header");
+    }
+    if (version != kVersion) {
+        return fail("unsupported batch version");
+    }
+    rows_ = num_rows;
+
+    for (uint32_t c = 0; c < num_columns; ++c) {
+        uint16_t name_len = 0;
+        const char* name = nullptr;
+        uint8_t type = 0;
+        if (!cur.Read(&name_len) || !cur.Skip(name_len, &name) || !cur.Read(&type)) {
+            return fail("truncated schema");
+        }
+        if (type < static_cast<uint8_t>(Type::Int32) || type > static_cast<uint8_t>(Type::String)) {
+            return fail("unknown column type");
+        }
+        fields_.push_back(Field{std::string(name, name_len), static_cast<Type>(type)});
+    }
+
+    const size_t bitmap_bytes = (rows_ + 7) / 8;
+    for (const auto& field : fields_) {
+        ColumnView view;
+        const char* start = nullptr;
+        if (!cur.Skip(bitmap_bytes, &start)) {
+            return fail("truncated validity bitmap");
+        }
+        view.valid = reinterpret_cast<const uint8_t*>(start);
+
+        switch (field.type) {
+            case Type::Int32:
+            case Type::Int64:
+            case Type::Float64:
+                if (!cur.Skip(rows_ * FixedWidth(field.type), &view.values)) {
+                    return fail("truncated values");
+                }
+                break;
+            case Type::Dictionary: {
+                uint32_t entries = 0;
+                if (!cur.Read(&entries)) {
+                    return fail("truncated dictionary");
+                }
+                for (uint32_t i = 0; i < entries; ++i) {
+                    uint32_t len = 0;
+                    const char* text = nullptr;
+                    if (!cur.Read(&len) || !cur.Skip(len, &text)) {
+                        return fail("truncated dictionary");
+                    }
+                    view.dictionary.emplace_back(text, len);
+                }
+                if (!cur.Skip(rows_ * sizeof(uint32_t), &view.values)) {
+                    return fail("truncated codes");
+                }
+                for (size_t r = 0; r < rows_; ++r) {
+                    if (Load<uint32_t>(view.values + r * sizeof(uint32_t)) >= entries) {
+                        return fail("dictionary code out of range");
+                    }
+                }
+                break;
+            }
+            case Type::String: {
+                if (!cur.Skip((rows_ + 1) * sizeof(uint32_t), &view.offsets)) {
+                    return fail("truncated offsets");
+                }
+                // Offsets only grow, so checking each against the one before
+                // and the last against the data bounds every string
+                uint32_t previous = 0;
+                for (size_t r = 0; r <= rows_; ++r) {
+                    uint32_t offset = Load<uint32_t>(view.offsets + r * sizeof(uint32_t));
+                    if (offset < previous) {
+                        return fail("string offsets out of order");
+                    }
+                    previous = offset;
+                }
+                if (!cur.Skip(previous, &view.bytes)) {
+                    return fail("truncated string data");
+                }
+                break;
+            }
+        }
+        columns_.push_back(std::move(view));
+    }
+    return true;
+}
+
+bool Reader::IsNull(size_t column, size_t row) const {
+    return (columns_[column].valid[row / 8] & (1u << (row % 8))) == 0;
+}
+
+int64_t Reader::Int(size_t column, size_t row) const {
+    const ColumnView& col = columns_[column];
+    if (fields_[column].type == Type::Int32) {
+        return Load<int32_t>(col.values + row * sizeof(int32_t));
+    }
+    return Load<int64_t>(col.values + row * sizeof(int64_t));
+}
+
+double Reader::Double(size_t column, size_t row) const {
+    return Load<double>(columns_[column].values + row * sizeof(double));
+}
+
+std::string_view Reader::Text(size_t column, size_t row) const {
+    const ColumnView& col = columns_[column];
+    if (fields_[column].type == Type::Dictionary) {
+        return col.dictionary[Load<uint32_t>(col.values + row * sizeof(uint32_t))];
+    }
+    uint32_t begin = Load<uint32_t>(col.offsets + row * sizeof(uint32_t));
+    uint32_t end = Load<uint32_t>(col.offsets + (row + 1) * sizeof(uint32_t));
+    return std::string_view(col.bytes + begin, end - begin);
+}
+
+std::string Reader::ToCsv() const {
+    std::ostringstream out;
+    for (size_t c = 0; c < fields_.size(); ++c) {
+        if (c > 0) out << ',';
+        AppendCsvField(out, fields_[c].name);
+    }
+    out << '\n';
+
+    char number[32];
+    for (size_t r = 0; r < rows_; ++r) {
+        for (size_t c = 0; c < fields_.size(); ++c) {
+            if (c > 0) out << ',';
+            if (IsNull(c, r)) {
+                continue;
+            }
+            switch (fields_[c].type) {
+                case Type::Int32:
+                case Type::Int64: out << Int(c, r); break;
+                case Type::Float64: {
+                    auto res = std::to_chars(number, number + sizeof(number), Double(c, r));
+                    out.write(number, res.ptr - number);
+                    break;
+                }
+                default: AppendCsvField(out, Text(c, r)); break;
+            }
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+}  // namespace colbatch
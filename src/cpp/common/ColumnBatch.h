@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Self-describing binary batch for WorkerResult payloads (Request.format =
+// COLUMNAR). Layout, all integers little-endian:
+//
+//   "M2CB" | u8 version | u32 columns | u32 rows
+//   per column:  u16 name length | name | u8 type
+//   per column:  validity bitmap ((rows + 7) / 8 bytes, bit set = present)
+//                then the values:
+//                  Int32 / Int64 / Float64  rows * 4 / 8 / 8 bytes
+//                  Dictionary               u32 entries, (u32 len | bytes) each,
+//                                           then rows * u32 codes
+//                  String                   (rows + 1) * u32 offsets | bytes
+//
+// Each batch carries its own schema and dictionaries, so chunks can be decoded
+// independently and in any order.
+namespace colbatch {
+
+enum class Type : uint8_t { Int32 = 1, Int64 = 2, Float64 = 3, Dictionary = 4, String = 5 };
+
+struct Field {
+    std::string name;
+    Type type = Type::String;
+};
+
+const char* TypeName(Type type);
+
+// True if `payload` starts with the batch magic (as opposed to CSV text)
+bool IsColumnBatch(std::string_view payload);
+
+class Writer {
+public:
+    explicit Writer(std::vector<Field> fields);
+
+    // One value per field, as text; numeric fields that fail to parse, are
+    // empty or don't fit the column type are stored as null
+    void AppendRow(const std::vector<std::string_view>& values);
+
+    size_t NumRows() const { return rows_; }
+
+    // Rough size of the serialized batch so far, for cutting output into parts
+    size_t ApproxBytes() const { return approx_bytes_; }
+
+    // Serialized batch, written into a buffer sized up front
+    std::string Finish() const;
+
+    // Exact length of what Finish() returns
+    size_t SerializedSize() const;
+
+private:
+    struct ColumnData {
+        std::vector<uint8_t> valid;
+        std::vector<int32_t> i32;
+        std::vector<int64_t> i64;
+        std::vector<double> f64;
+        std::vector<uint32_t> codes;
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, uint32_t> code_index;
+        std::vector<uint32_t> offsets{0};
+        std::string bytes;
+    };
+
+    std::vector<Field> fields_;
+    std::vector<ColumnData> columns_;
+    size_t rows_ = 0;
+    size_t approx_bytes_ = 0;
+};
+
+class Reader {
+public:
+    // Validates and indexes `data`, which must outlive the reader; every
+    // length, offset and code is checked against the buffer, so a truncated
+    // or corrupt batch fails here instead of being read out of bounds
+    bool Parse(std::string_view data, std::string* error);
+
+    size_t NumRows() const { return rows_; }
+    size_t NumColumns() const { return fields_.size(); }
+    const Field& FieldAt(size_t column) const { return fields_[column]; }
+
+    bool IsNull(size_t column, size_t row) const;
+    int64_t Int(size_t column, size_t row) const;         // Int32 / Int64
+    double Double(size_t column, size_t row) const;       // Float64
+    std::string_view Text(size_t column, size_t row) const;  // Dictionary / String
+
+    // Back to CSV (header + rows), e.g. for printing. Values match the source
+    // text, but floats come out in shortest round-trip form, so "57.067140"
+    // reads back as "57.06714".
+    std::string ToCsv() const;
+
+private:
+    struct ColumnView {
+        const uint8_t* valid = nullptr;
+        const char* values = nullptr;               // fixed-width values or codes
+        std::vector<std::string_view> dictionary;
+        const char* offsets = nullptr;              // String: rows + 1 offsets
+        const char* bytes = nullptr;
+    };
+
+    std::vector<Field> fields_;
+    std::vector<ColumnView> columns_;
+    size_t rows_ = 0;
+};
+
+}  // namespace colbatch
@@ -0,0 +1,251 @@
+#include "Aggregator.h"
+#include "CsvScanner.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace {
+
+const char kKeySeparator = '\x1f';
+
+std::string MeasureLabel(const mini2::Aggregation::Measure& m) {
+    switch (m.func()) {
+        case mini2::Aggregation::COUNT: return "count";
+        case mini2::Aggregation::SUM: return "sum(" + m.column() + ")";
+        case mini2::Aggregation::MIN: return "min(" + m.column() + ")";
+        case mini2::Aggregation::MAX: return "max(" + m.column() + ")";
+        case mini2::Aggregation::AVG: return "avg(" + m.column() + ")";
+        default: return "?";
+    }
+}
+
+void WriteNumber(std::ostringstream& out, double value) {
+    if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 1e15) {
+        out << static_cast<int64_t>(value);
+    } else {
+        out << std::setprecision(10) << value;
+    }
+}
+
+std::string JoinKeys(const mini2::AggregateState::Group& g) {
+    std::string key;
+    for (const auto& k : g.keys()) {
+        key += k;
+        key += kKeySeparator;
+    }
+    return key;
+}
+
+}  // namespace
+
+bool Aggregator::Compile(const mini2::Aggregation& spec, const DataProcessor& data, std::string* error) {
+    const Schema& schema = data.GetSchema();
+    const ColumnStore* store = data.GetColumnStore();
+
+    measures_.clear();
+    key_parts_.clear();
+    groups_.clear();
+
+    for (const auto& m : spec.measures()) {
+        Measure measure;
+        measure.func = m.func();
+        if (m.func() != mini2::Aggregation::COUNT) {
+            const ColumnSpec* col = schema.Find(m.column());
+            if (!col) {
+                if (error) *error = "unknown column '" + m.column() + "'";
+                return false;
+            }
+            if (col->type == ColumnType::Dictionary) {
+                if (error) *error = "column '" + m.column() + "' is not numeric";
+                return false;
+            }
+            measure.field = col->index;
+            measure.type = col->type;
+            measure.column = store ? store->Find(col->index) : nullptr;
+        }
+        measures_.push_back(measure);
+    }
+
+    for (const auto& name : spec.group_by()) {
+        const ColumnSpec* col = schema.Find(name);
+        if (!col) {
+            if (error) *error = "unknown group-by column '" + name + "'";
+            return false;
+        }
+        KeyPart part;
+        part.field = col->index;
+        const Column* stored = store ? store->Find(col->index) : nullptr;
+        if (stored && stored->type == ColumnType::Dictionary) {
+            part.dictionary = stored;
+        }
+        key_parts_.push_back(part);
+    }
+    return true;
+}
+
+double Aggregator::MeasureValue(const Measure& m, const CSVRow& row) const {
+    // Same number (or NaN) with or without the column store
+    return m.column ? m.column->ValueAt(row.Index())
+                    : ColumnStore::ParseValue(m.type, csv::FieldAt(row.View(), m.field));
+}
+
+void Aggregator::Accumulate(const CSVRow& row) {
+    key_buffer_.clear();
+    for (const auto& part : key_parts_) {
+        if (part.dictionary) {
+            uint32_t code = part.dictionary->codes[row.Index()];
+            key_buffer_.append(reinterpret_cast<const char*>(&code), sizeof(code));
+        } else {
+            key_buffer_.append(csv::FieldAt(row.View(), part.field));
+            key_buffer_ += kKeySeparator;
+        }
+    }
+
+    auto it = groups_.find(key_buffer_);
+    if (it == groups_.end()) {
+        Group group;
+        for (const auto& part : key_parts_) {
+            if (part.dictionary) {
+                group.keys.push_back(part.dictionary->dictionary[part.dictionary->codes[row.Index()]]);
+            } else {
+                group.keys.emplace_back(csv::FieldAt(row.View(), part.field));
+            }
+        }
+        group.sum.assign(measures_.size(), 0.0);
+        group.min.assign(measures_.size(), std::numeric_limits<double>::infinity());
+        group.max.assign(measures_.size(), -std::numeric_limits<double>::infinity());
+        group.count.assign(measures_.size(), 0);
+        it = groups_.emplace(key_buffer_, std::move(group)).first;
+    }
+
+    Group& group = it->second;
+    group.rows++;
+    for (size_t i = 0; i < measures_.size(); ++i) {
+        if (measures_[i].func == mini2::Aggregation::COUNT) {
+            continue;
+        }
+        double value = MeasureValue(measures_[i], row);
+        if (std::isnan(value)) {
+            continue;  // empty / non-numeric field
+        }
+        group.sum[i] += value;
+        group.min[i] = std::min(group.min[i], value);
+        group.max[i] = std::max(group.max[i], value);
+        group.count[i]++;
+    }
+}
+
+void Aggregator::AccumulateChunk(RowRange chunk, const RowFilter& filter) {
+    const bool filtering = !filter.Empty();
+    for (const auto& row : chunk) {
+        if (filtering && !filter.Matches(row)) {
+            continue;
+        }
+        Accumulate(row);
+    }
+}
+
+void Aggregator::ToState(mini2::AggregateState* out) const {
+    out->clear_groups();
+    for (const auto& [key, group] : groups_) {
+        auto* g = out->add_groups();
+        for (const auto& k : group.keys) {
+            g->add_keys(k);
+        }
+        g->set_rows(group.rows);
+        for (size_t i = 0; i < measures_.size(); ++i) {
+            g->add_sum(group.sum[i]);
+            g->add_min(group.min[i]);
+            g->add_max(group.max[i]);
+            g->add_count(group.count[i]);
+        }
+    }
+}
+
+void Aggregator::Merge(const mini2::AggregateState& from, mini2::AggregateState* into) {
+    std::unordered_map<std::string, int> index;
+    for (int i = 0; i < into->groups_size(); ++i) {
+        index.emplace(JoinKeys(into->groups(i)), i);
+    }
+
+    for (const auto& g : from.groups()) {
+        auto it = index.find(JoinKeys(g));
+        if (it == index.end()) {
+            index.emplace(JoinKeys(g), into->groups_size());
+            *into->add_groups() = g;
+            continue;
+        }
+
+        auto* dst = into->mutable_groups(it->second);
+        dst->set_rows(dst->rows() + g.rows());
+        const int n = std::min(dst->sum_size(), g.sum_size());
+        for (int i = 0; i < n; ++i) {
+            dst->set_sum(i, dst->sum(i) + g.sum(i));
+            dst->set_min(i, std::min(dst->min(i), g.min(i)));
+            dst->set_max(i, std::max(dst->max(i), g.max(i)));
+            dst->set_count(i, dst->count(i) + g.count(i));
+        }
+    }
+}
+
+std::string Aggregator::Render(const mini2::Aggregation& spec, const mini2::AggregateState& state) {
+    std::ostringstream out;
+
+    // Header
+    bool first = true;
+    for (const auto& name : spec.group_by()) {
+        out << (first ? "" : ",") << name;
+        first = false;
+    }
+    for (const auto& m : spec.measures()) {
+        out << (first ? "" : ",") << MeasureLabel(m);
+        first = false;
+    }
+    out << "\n";
+
+    // Groups sorted by key so output is stable across runs
+    std::map<std::string, const mini2::AggregateState::Group*> sorted;
+    for (const auto& g : state.groups()) {
+        sorted.emplace(JoinKeys(g), &g);
+    }
+
+    for (const auto& [key, g] : sorted) {
+        first = true;
+        for (const auto& k : g->keys()) {
+            std::string field;
+            csv::AppendField(field, k);
+            out << (first ? "" : ",") << field;
+            first = false;
+        }
+        for (int i = 0; i < spec.measures_size(); ++i) {
+            out << (first ? "" : ",");
+            first = false;
+
+            const bool has_values = i < g->count_size() && g->count(i) > 0;
+            switch (spec.measures(i).func()) {
+                case mini2::Aggregation::COUNT:
+                    out << g->rows();
+                    break;
+                case mini2::Aggregation::SUM:
+                    if (has_values) WriteNumber(out, g->sum(i));
+                    break;
+                case mini2::Aggregation::MIN:
+                    if (has_values) WriteNumber(out, g->min(i));
+                    break;
+                case mini2::Aggregation::MAX:
+                    if (has_values) WriteNumber(out, g->max(i));
+                    break;
+                case mini2::Aggregation::AVG:
+                    if (has_values) WriteNumber(out, g->sum(i) / static_cast<double>(g->count(i)));
+                    break;
+                default:
+                    break;
+            }
+        }
+        out << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "minitwo.pb.h"
+#include "DataProcessor.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Partial aggregation of dataset rows (workers) and merging of partials
+// (team leaders and A). Group keys on dictionary columns are built from
+// integer codes; other columns use their text.
+class Aggregator {
+public:
+    // Resolve measures and group-by columns against `data`
+    bool Compile(const mini2::Aggregation& spec, const DataProcessor& data, std::string* error);
+
+    // Add one (already filtered) row
+    void Accumulate(const CSVRow& row);
+
+    // Add every row of `chunk` that passes `filter`
+    void AccumulateChunk(RowRange chunk, const RowFilter& filter);
+
+    // Partial state to ship upstream
+    void ToState(mini2::AggregateState* out) const;
+
+    size_t NumGroups() const { return groups_.size(); }
+
+    // Fold `from` into `into` (groups matched by key values)
+    static void Merge(const mini2::AggregateState& from, mini2::AggregateState* into);
+
+    // Final CSV: group_by columns, then one column per measure
+    static std::string Render(const mini2::Aggregation& spec, const mini2::AggregateState& state);
+
+private:
+    struct Measure {
+        mini2::Aggregation::Func func = mini2::Aggregation::COUNT;
+        size_t field = 0;
+        ColumnType type = ColumnType::String;
+        const Column* column = nullptr;  // typed values when materialized
+    };
+
+    struct KeyPart {
+        size_t field = 0;
+        const Column* dictionary = nullptr;  // group on codes when set
+    };
+
+    struct Group {
+        std::vector<std::string> keys;
+        uint64_t rows = 0;
+        std::vector<double> sum, min, max;
+        std::vector<uint64_t> count;
+    };
+
+    double MeasureValue(const Measure& m, const CSVRow& row) const;
+
+    std::vector<Measure> measures_;
+    std::vector<KeyPart> key_parts_;
+    std::unordered_map<std::string, Group> groups_;
+    std::string key_buffer_;  // reused per row to avoid allocating on lookups
+};
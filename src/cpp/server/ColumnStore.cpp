@@ -0,0 +1,234 @@
+#include "ColumnStore.h"
+#include "CsvScanner.h"
+#include "DataProcessor.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// Rows per thread below which building in parallel is not worth it
+constexpr size_t kMinRowsPerBuildThread = 64 * 1024;
+
+int64_t DaysFromCivil(int64_t y, unsigned m, unsigned d) {
+    // Howard Hinnant's days_from_civil
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+// Parses a leading unsigned integer and advances `text` past it and one separator
+bool TakeNumber(std::string_view& text, int& out) {
+    auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+    if (res.ec != std::errc()) {
+        return false;
+    }
+    size_t used = static_cast<size_t>(res.ptr - text.data());
+    text.remove_prefix(std::min(text.size(), used + 1));
+    return true;
+}
+
+// Whole leading integer; false if the field doesn't start with one
+bool TryParseInt(std::string_view text, int64_t* out) {
+    return std::from_chars(text.data(), text.data() + text.size(), *out).ec == std::errc();
+}
+
+}  // namespace
+
+int64_t Column::LookupCode(std::string_view value) const {
+    auto it = code_index_.find(std::string(value));
+    return (it == code_index_.end()) ? -1 : static_cast<int64_t>(it->second);
+}
+
+double Column::ValueAt(size_t row) const {
+    switch (type) {
+        case ColumnType::Float64:
+            return f64[row];
+        case ColumnType::Int32:
+            return i32[row] == kMissing32 ? std::nan("") : i32[row];
+        case ColumnType::Int64:
+        case ColumnType::Timestamp:
+            return i64[row] == kMissing64 ? std::nan("") : static_cast<double>(i64[row]);
+        case ColumnType::String:
+            return csv::ParseDouble(text[row]);
+        default:
+            return std::nan("");
+    }
+}
+
+bool ColumnStore::TryParseTimestamp(std::string_view text, int64_t* out) {
+    int month = 0, day = 0, year = 0, hour = 0, minute = 0;
+    if (!TakeNumber(text, month) || !TakeNumber(text, day) || !TakeNumber(text, year) ||
+        !TakeNumber(text, hour) || !TakeNumber(text, minute)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    if (year < 100) {
+        year += 2000;  // gen_test_data.py writes two-digit years
+    }
+    *out = DaysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+           hour * 3600 + minute * 60;
+    return true;
+}
+
+double ColumnStore::ParseValue(ColumnType type, std::string_view field) {
+    int64_t value = 0;
+    switch (type) {
+        case ColumnType::Int64:
+            return TryParseInt(field, &value) ? static_cast<double>(value) : std::nan("");
+        case ColumnType::Timestamp:
+            return TryParseTimestamp(field, &value) ? static_cast<double>(value) : std::nan("");
+        case ColumnType::Int32:
+            return TryParseInt(field, &value) ? static_cast<int32_t>(value) : std::nan("");
+        default:
+            return csv::ParseDouble(field);
+    }
+}
+
+void ColumnStore::Build(const Schema& schema, const std::vector<CSVRow>& rows, unsigned threads,
+                        BuildMode mode) {
+    columns_.clear();
+    field_index_.clear();
+    by_field_.assign(schema.NumColumns(), -1);
+    num_rows_ = rows.size();
+
+    for (size_t f = 0; f < schema.NumColumns(); ++f) {
+        Column col;
+        col.name = schema.At(f).name;
+        col.type = schema.At(f).type;
+        if (mode == BuildMode::DictionaryOnly && col.type != ColumnType::Dictionary) {
+            continue;
+        }
+        switch (col.type) {
+            case ColumnType::Float64: col.f64.resize(num_rows_); break;
+            case ColumnType::Int64:
+            case ColumnType::Timestamp: col.i64.resize(num_rows_); break;
+            case ColumnType::Int32: col.i32.resize(num_rows_); break;
+            case ColumnType::Dictionary: col.codes.resize(num_rows_); break;
+            case ColumnType::String: col.text.resize(num_rows_); break;
+        }
+        by_field_[f] = static_cast<int>(columns_.size());
+        columns_.push_back(std::move(col));
+        field_index_.push_back(f);
+    }
+
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(
+        threads, num_rows_ / kMinRowsPerBuildThread));
+    const size_t rows_per_worker = (num_rows_ + workers - 1) / workers;
+
+    // Each worker encodes against its own dictionaries (local codes) ...
+    std::vector<std::vector<std::vector<std::string_view>>> local_dicts(
+        workers, std::vector<std::vector<std::string_view>>(columns_.size()));
+    std::vector<std::thread> builders;
+    for (size_t w = 0; w < workers; ++w) {
+        size_t begin = std::min(num_rows_, w * rows_per_worker);
+        size_t end = std::min(num_rows_, begin + rows_per_worker);
+        builders.emplace_back(&ColumnStore::ParseRange, this, std::cref(rows), begin, end,
+                              std::ref(local_dicts[w]));
+    }
+    for (auto& b : builders) {
+        b.join();
+    }
+
+    // ... then local dictionaries are merged in row order and codes remapped
+    for (size_t c = 0; c < columns_.size(); ++c) {
+        Column& col = columns_[c];
+        if (col.type != ColumnType::Dictionary) {
+            continue;
+        }
+
+        std::vector<std::vector<uint32_t>> remap(workers);
+        for (size_t w = 0; w < workers; ++w) {
+            for (const auto& value : local_dicts[w][c]) {
+                std::string key(value);
+                auto it = col.code_index_.find(key);
+                if (it == col.code_index_.end()) {
+                    it = col.code_index_.emplace(key, static_cast<uint32_t>(col.dictionary.size())).first;
+                    col.dictionary.push_back(key);
+                }
+                remap[w].push_back(it->second);
+            }
+        }
+
+        for (size_t w = 0; w < workers; ++w) {
+            size_t begin = std::min(num_rows_, w * rows_per_worker);
+            size_t end = std::min(num_rows_, begin + rows_per_worker);
+            for (size_t r = begin; r < end; ++r) {
+                col.codes[r] = remap[w][col.codes[r]];
+            }
+        }
+    }
+
+    std::cout << "[ColumnStore] built " << columns_.size() << " column(s) x " << num_rows_
+              << " row(s), ~" << (MemoryBytes() >> 20) << " MB" << std::endl;
+}
+
+void ColumnStore::ParseRange(const std::vector<CSVRow>& rows, size_t begin, size_t end,
+                             std::vector<std::vector<std::string_view>>& local_dicts) {
+    std::vector<std::unordered_map<std::string_view, uint32_t>> index(columns_.size());
+    std::vector<std::string_view> fields;
+    int64_t value = 0;
+
+    for (size_t r = begin; r < end; ++r) {
+        csv::SplitFields(rows[r].View(), ',', fields);
+
+        for (size_t c = 0; c < columns_.size(); ++c) {
+            const size_t f = field_index_[c];
+            std::string_view field = (f < fields.size()) ? fields[f] : std::string_view();
+            Column& col = columns_[c];
+            switch (col.type) {
+                case ColumnType::Float64:
+                    col.f64[r] = csv::ParseDouble(field);
+                    break;
+                case ColumnType::Int64:
+                    col.i64[r] = TryParseInt(field, &value) ? value : Column::kMissing64;
+                    break;
+                case ColumnType::Timestamp:
+                    col.i64[r] = TryParseTimestamp(field, &value) ? value : Column::kMissing64;
+                    break;
+                case ColumnType::Int32:
+                    col.i32[r] = TryParseInt(field, &value) ? static_cast<int32_t>(value) : Column::kMissing32;
+                    break;
+                case ColumnType::Dictionary: {
+                    auto it = index[c].find(field);
+                    if (it == index[c].end()) {
+                        it = index[c].emplace(field, static_cast<uint32_t>(local_dicts[c].size())).first;
+                        local_dicts[c].push_back(field);
+                    }
+                    col.codes[r] = it->second;
+                    break;
+                }
+                case ColumnType::String:
+                    col.text[r] = field;
+                    break;
+            }
+        }
+    }
+}
+
+const Column* ColumnStore::Find(size_t field_index) const {
+    if (field_index >= by_field_.size() || by_field_[field_index] < 0) {
+        return nullptr;
+    }
+    return &columns_[by_field_[field_index]];
+}
+
+size_t ColumnStore::MemoryBytes() const {
+    size_t bytes = 0;
+    for (const auto& col : columns_) {
+        bytes += col.f64.size() * sizeof(double) + col.i64.size() * sizeof(int64_t) +
+                 col.i32.size() * sizeof(int32_t) + col.codes.size() * sizeof(uint32_t) +
+                 col.text.size() * sizeof(std::string_view);
+        for (const auto& value : col.dictionary) {
+            bytes += value.size();
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Schema.h"
+
+class CSVRow;
+
+// One typed column. Only the vector matching `type` is populated.
+struct Column {
+    std::string name;
+    ColumnType type = ColumnType::String;
+
+    // Empty or malformed fields are NaN in f64 and kMissing* in the integer
+    // arrays
+    static constexpr int64_t kMissing64 = std::numeric_limits<int64_t>::min();
+    static constexpr int32_t kMissing32 = std::numeric_limits<int32_t>::min();
+
+    std::vector<double> f64;
+    std::vector<int64_t> i64;             // Int64 and Timestamp
+    std::vector<int32_t> i32;
+    std::vector<uint32_t> codes;          // Dictionary: row -> dense code in [0, dictionary.size())
+    std::vector<std::string> dictionary;  // Dictionary: code -> value
+    std::vector<std::string_view> text;   // String
+
+    // Code for `value`, or -1 if it never occurs in this column
+    int64_t LookupCode(std::string_view value) const;
+
+    // Numeric value at `row`, NaN where the field was empty or malformed;
+    // the same number ColumnStore::ParseValue gives for the field
+    double ValueAt(size_t row) const;
+
+private:
+    friend class ColumnStore;
+    std::unordered_map<std::string, uint32_t> code_index_;
+};
+
+// Column-oriented copy of a loaded dataset, built once at load time with the
+// column types of the dataset's Schema.
+class ColumnStore {
+public:
+    // Full materializes every column; DictionaryOnly keeps just the
+    // dictionary-encoded ones (4 bytes per row each), which is enough for
+    // code-based equality filters and grouping.
+    enum class BuildMode { Full, DictionaryOnly };
+
+    // Parse every row into typed columns, splitting the rows across `threads`
+    void Build(const Schema& schema, const std::vector<CSVRow>& rows, unsigned threads,
+               BuildMode mode = BuildMode::Full);
+
+    size_t NumRows() const { return num_rows_; }
+    size_t NumColumns() const { return columns_.size(); }
+    const Column& At(size_t index) const { return columns_[index]; }
+
+    // Column for schema field `field_index`; nullptr if it was not materialized
+    const Column* Find(size_t field_index) const;
+
+    // Approximate heap footprint of the typed arrays
+    size_t MemoryBytes() const;
+
+    // "M/D/YY H:MM" (UTC) -> unix seconds; false if malformed
+    static bool TryParseTimestamp(std::string_view text, int64_t* out);
+
+    // The value Build stores for `field` in a numeric column of `type`, as a
+    // double (NaN when empty or malformed), so code reading fields straight
+    // from the row agrees with code reading the column
+    static double ParseValue(ColumnType type, std::string_view field);
+
+private:
+    void ParseRange(const std::vector<CSVRow>& rows, size_t begin, size_t end,
+                    std::vector<std::vector<std::string_view>>& local_dicts);
+
+    std::vector<Column> columns_;
+    std::vector<size_t> field_index_;  // columns_[i] is field field_index_[i] of a row
+    std::vector<int> by_field_;        // field index -> position in columns_, or -1
+    size_t num_rows_ = 0;
+};
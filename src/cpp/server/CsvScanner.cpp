@@ -0,0 +1,217 @@
+#include "CsvScanner.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr char kQuote = '"';
+
+#if defined(__AVX2__)
+constexpr size_t kBlock = 32;
+
+inline uint32_t MatchMask(const char* p, char c) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i hits = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+}
+#elif defined(__SSE2__)
+constexpr size_t kBlock = 16;
+
+inline uint32_t MatchMask(const char* p, char c) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c));
+    return static_cast<uint32_t>(_mm_movemask_epi8(hits));
+}
+#else
+constexpr size_t kBlock = 0;
+
+inline uint32_t MatchMask(const char*, char) {
+    return 0;
+}
+#endif
+
+inline int LowestBit(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+
+// Calls on_boundary(offset, is_quote) for every delimiter/quote in line, in order.
+// Returning false from the callback stops the scan.
+template <typename Fn>
+void ForEachStructural(std::string_view line, char delimiter, Fn&& on_boundary) {
+    const char* base = line.data();
+    const size_t size = line.size();
+    size_t pos = 0;
+
+    if (kBlock != 0) {
+        for (; pos + kBlock <= size; pos += kBlock) {
+            uint32_t delims = MatchMask(base + pos, delimiter);
+            uint32_t quotes = MatchMask(base + pos, kQuote);
+            uint32_t mask = delims | quotes;
+            while (mask != 0) {
+                int bit = LowestBit(mask);
+                if (!on_boundary(pos + bit, ((quotes >> bit) & 1u) != 0)) {
+                    return;
+                }
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    for (; pos < size; ++pos) {
+        char c = base[pos];
+        if (c == delimiter || c == kQuote) {
+            if (!on_boundary(pos, c == kQuote)) {
+                return;
+            }
+        }
+    }
+}
+
+inline std::string_view TrimQuotes(std::string_view field) {
+    if (field.size() >= 2 && field.front() == kQuote && field.back() == kQuote) {
+        return field.substr(1, field.size() - 2);
+    }
+    return field;
+}
+
+}  // namespace
+
+namespace csv {
+
+const char* ScannerIsa() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+const char* FindNewline(const char* begin, const char* end) {
+    const char* p = begin;
+
+    if (kBlock != 0) {
+        for (; p + kBlock <= end; p += kBlock) {
+            uint32_t mask = MatchMask(p, '\n');
+            if (mask != 0) {
+                return p + LowestBit(mask);
+            }
+        }
+    }
+
+    for (; p < end; ++p) {
+        if (*p == '\n') {
+            return p;
+        }
+    }
+    return end;
+}
+
+size_t SplitFields(std::string_view line, char delimiter, std::vector<std::string_view>& out) {
+    out.clear();
+    size_t field_start = 0;
+    bool in_quotes = false;
+
+    ForEachStructural(line, delimiter, [&](size_t offset, bool is_quote) {
+        if (is_quote) {
+            in_quotes = !in_quotes;
+        } else if (!in_quotes) {
+            out.push_back(TrimQuotes(line.substr(field_start, offset - field_start)));
+            field_start = offset + 1;
+        }
+        return true;
+    });
+
+    out.push_back(TrimQuotes(line.substr(field_start)));
+    return out.size();
+}
+
+std::string_view FieldAt(std::string_view line, size_t index, char delimiter) {
+    size_t current = 0;
+    size_t field_start = 0;
+    size_t field_end = std::string_view::npos;
+    bool in_quotes = false;
+
+    ForEachStructural(line, delimiter, [&](size_t offset, bool is_quote) {
+        if (is_quote) {
+            in_quotes = !in_quotes;
+            return true;
+        }
+        if (in_quotes) {
+            return true;
+        }
+        if (current == index) {
+            field_end = offset;
+            return false;
+        }
+        ++current;
+        field_start = offset + 1;
+        return true;
+    });
+
+    if (current != index) {
+        return std::string_view();
+    }
+    if (field_end == std::string_view::npos) {
+        field_end = line.size();
+    }
+    return TrimQuotes(line.substr(field_start, field_end - field_start));
+}
+
+void AppendField(std::string& out, std::string_view field, char delimiter) {
+    bool plain = true;
+    for (char c : field) {
+        if (c == delimiter || c == kQuote || c == '\n' || c == '\r') {
+            plain = false;
+            break;
+        }
+    }
+    if (plain) {
+        out.append(field);
+        return;
+    }
+    out += kQuote;
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (field[i] != kQuote) {
+            out += field[i];
+            continue;
+        }
+        out += kQuote;
+        out += kQuote;
+        if (i + 1 < field.size() && field[i + 1] == kQuote) {
+            ++i;
+        }
+    }
+    out += kQuote;
+}
+
+int64_t ParseInt(std::string_view text) {
+    int64_t value = 0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+double ParseDouble(std::string_view text) {
+    // strtod needs a terminated string; fields here are short
+    char buf[64];
+    if (text.empty() || text.size() >= sizeof(buf)) {
+        return std::nan("");
+    }
+    std::copy(text.begin(), text.end(), buf);
+    buf[text.size()] = '\0';
+    char* end = nullptr;
+    double value = std::strtod(buf, &end);
+    return (end == buf) ? std::nan("") : value;
+}
+
+}  // namespace csv
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized CSV structural scanning (AVX2 or SSE2 when the compiler targets
+// them, scalar otherwise). Compares whole blocks against the delimiter, quote
+// and newline characters and walks the resulting bitmasks, so per-byte work
+// only happens at field/row boundaries.
+namespace csv {
+
+// Name of the code path compiled in ("avx2", "sse2" or "scalar")
+const char* ScannerIsa();
+
+// First '\n' in [begin, end), or end if there is none
+const char* FindNewline(const char* begin, const char* end);
+
+// Split one line into field views (no copies). A delimiter inside a quoted
+// field does not split it; surrounding quotes are stripped from the view,
+// doubled quotes inside are left as-is. Returns the number of fields.
+size_t SplitFields(std::string_view line, char delimiter, std::vector<std::string_view>& out);
+
+// Field at `index` without splitting the rest of the line (empty if missing)
+std::string_view FieldAt(std::string_view line, size_t index, char delimiter = ',');
+
+// Append a field as SplitFields returns it to `out` as one CSV field: as-is
+// unless it holds the delimiter, a quote or a line break, otherwise quoted,
+// with lone quotes doubled (pairs the source already doubled are kept)
+void AppendField(std::string& out, std::string_view field, char delimiter = ',');
+
+// Text -> number for field values. ParseInt returns 0 and ParseDouble NaN
+// when the field is empty or not a number.
+int64_t ParseInt(std::string_view text);
+double ParseDouble(std::string_view text);
+
+}  // namespace csv
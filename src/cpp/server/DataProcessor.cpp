@@ -1,111 +1,438 @@
 #include "DataProcessor.h"
+#include "ColumnBatch.h"
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <chrono>
+#include <thread>
 
-DataProcessor::DataProcessor(const std::string& dataset_path) 
-    : dataset_path_(dataset_path), header_("") {
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MINI2_HAVE_MMAP 1
+#endif
+
+namespace {
+// Below this many bytes per thread, spawning costs more than scanning
+constexpr size_t kMinBytesPerLoadThread = 4 * 1024 * 1024;
+}
+
+DataProcessor::DataProcessor(const std::string& dataset_path, LoadMode mode, unsigned load_threads) 
+    : dataset_path_(dataset_path), mode_(mode), load_threads_(load_threads), header_("") {
+    if (load_threads_ == 0) {
+        load_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+DataProcessor::~DataProcessor() {
+    Unmap();
 }
 
 bool DataProcessor::LoadDataset() {
-    std::ifstream file(dataset_path_);
-    if (!file.is_open()) {
+    std::cout << "[DataProcessor] loading " << dataset_path_ 
+              << (mode_ == LoadMode::Mmap ? " (mmap" : " (stream") 
+              << ", scanner=" << csv::ScannerIsa() << ")" << std::endl;
+
+    header_.clear();
+    schema_ = Schema();
+    data_.clear();
+    columns_.reset();
+    auto start = std::chrono::steady_clock::now();
+
+    bool loaded = false;
+    if (mode_ == LoadMode::Mmap) {
+        loaded = MapFile();
+        if (!loaded) {
+            std::cerr << "[DataProcessor] mmap unavailable, falling back to stream read" << std::endl;
+        }
+    }
+    if (!loaded && !ReadFile()) {
         std::cerr << "[DataProcessor] can't open dataset: " << dataset_path_ << std::endl;
         return false;
     }
+
+    schema_ = Schema(header_);
+
+    if (!data_.empty()) {
+        columns_ = std::make_unique<ColumnStore>();
+        columns_->Build(schema_, data_, load_threads_,
+                        build_columns_ ? ColumnStore::BuildMode::Full
+                                       : ColumnStore::BuildMode::DictionaryOnly);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[DataProcessor] loaded " << data_.size() << " row(s) in " 
+              << elapsed << " ms" << std::endl;
     
-    std::cout << "[DataProcessor] loading " << dataset_path_ << std::endl;
-    
-    // Read and store header
-    std::getline(file, header_);
-    
-    int row_count = 0;
-    int empty_lines = 0;
-    std::string line;
-    
-    while (std::getline(file, line)) {
-        if (line.empty()) {
-            empty_lines++;
-            continue;
+    return !data_.empty();
+}
+
+bool DataProcessor::MapFile() {
+#ifdef MINI2_HAVE_MMAP
+    Unmap();
+
+    int fd = ::open(dataset_path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // Mapping stays valid after the descriptor is closed
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    // The newline scan below walks the file front to back once
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    mapping_ = addr;
+    mapping_size_ = size;
+
+    const char* begin = static_cast<const char*>(mapping_);
+    IndexRows(begin, begin + mapping_size_);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DataProcessor::ReadFile() {
+    std::ifstream file(dataset_path_, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (size <= 0) {
+        return false;
+    }
+
+    buffer_.resize(static_cast<size_t>(size));
+    file.read(&buffer_[0], size);
+    buffer_.resize(static_cast<size_t>(file.gcount()));
+
+    IndexRows(buffer_.data(), buffer_.data() + buffer_.size());
+    return true;
+}
+
+void DataProcessor::Unmap() {
+#ifdef MINI2_HAVE_MMAP
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mapping_size_);
+    }
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+}
+
+void DataProcessor::IndexRows(const char* begin, const char* end) {
+    // Header is the first line
+    const char* nl = csv::FindNewline(begin, end);
+    const char* header_end = nl;
+    if (header_end != begin && header_end[-1] == '\r') {
+        --header_end;  // CRLF files (csv.writer default)
+    }
+    header_.assign(begin, header_end);
+    const char* pos = (nl != end) ? nl + 1 : end;
+
+    const size_t body_size = static_cast<size_t>(end - pos);
+    const size_t threads = std::max<size_t>(1, std::min<size_t>(
+        load_threads_, body_size / kMinBytesPerLoadThread));
+
+    if (threads == 1) {
+        ScanRows(pos, end, end, data_);
+        return;
+    }
+
+    // Each thread owns the rows that start in its byte range
+    std::vector<std::vector<CSVRow>> partials(threads);
+    std::vector<std::thread> scanners;
+    const size_t range_size = body_size / threads;
+    for (size_t t = 0; t < threads; ++t) {
+        const char* range_begin = pos + t * range_size;
+        const char* range_end = (t == threads - 1) ? end : range_begin + range_size;
+        scanners.emplace_back(ScanRows, range_begin, range_end, end, std::ref(partials[t]));
+    }
+    for (auto& scanner : scanners) {
+        scanner.join();
+    }
+
+    // Merge: size once, then copy each partial into its slot in parallel
+    std::vector<size_t> offsets(threads + 1, 0);
+    for (size_t t = 0; t < threads; ++t) {
+        offsets[t + 1] = offsets[t] + partials[t].size();
+    }
+    data_.resize(offsets[threads]);
+
+    scanners.clear();
+    for (size_t t = 0; t < threads; ++t) {
+        scanners.emplace_back([this, &partials, &offsets, t]() {
+            const auto& part = partials[t];
+            for (size_t i = 0; i < part.size(); ++i) {
+                data_[offsets[t] + i] = CSVRow(part[i].View(), offsets[t] + i);
+            }
+            std::vector<CSVRow>().swap(partials[t]);
+        });
+    }
+    for (auto& scanner : scanners) {
+        scanner.join();
+    }
+
+    std::cout << "[DataProcessor] indexed " << body_size << " bytes with " 
+              << threads << " thread(s)" << std::endl;
+}
+
+void DataProcessor::ScanRows(const char* range_begin, const char* range_end,
+                             const char* file_end, std::vector<CSVRow>& out) {
+    const char* pos = range_begin;
+
+    // A range that begins mid-row leaves that row to the previous range.
+    // Every range sits after the header, so range_begin[-1] is readable.
+    if (range_begin[-1] != '\n') {
+        const char* nl = csv::FindNewline(pos, file_end);
+        pos = (nl != file_end) ? nl + 1 : file_end;
+    }
+
+    out.reserve((range_end - range_begin) / 64);
+
+    while (pos < range_end) {
+        const char* line_end = csv::FindNewline(pos, file_end);
+        const char* next = line_end + 1;
+        if (line_end != pos && line_end[-1] == '\r') {
+            --line_end;
         }
-        
-        // Store raw line as CSVRow
-        data_.emplace_back(line);
-        row_count++;
-        
-        // Progress indicator for large files
-        if (row_count % 100000 == 0) {
-            std::cout << "[DataProcessor] Progress: " << row_count << " rows loaded" << std::endl;
+        if (line_end != pos) {
+            out.emplace_back(std::string_view(pos, line_end - pos), out.size());
         }
+        pos = next;
     }
-    
-    file.close();
-    std::cout << "[DataProcessor] loaded " << row_count << " row(s)" << std::endl;
-    
-    return row_count > 0;
 }
 
-std::vector<CSVRow> DataProcessor::GetChunk(size_t start_idx, size_t count) {
-    std::vector<CSVRow> chunk;
-    
+std::string_view DataProcessor::GetField(const CSVRow& row, const std::string& column) const {
+    int index = schema_.IndexOf(column);
+    return (index < 0) ? std::string_view() : csv::FieldAt(row.View(), static_cast<size_t>(index));
+}
+
+RowRange DataProcessor::GetChunk(size_t start_idx, size_t count) const {
     if (start_idx >= data_.size()) {
         std::cerr << "[DataProcessor] bad start_idx " << start_idx 
               << " (size=" << data_.size() << ")" << std::endl;
-        return chunk;
+        return RowRange();
     }
     
-    size_t end_idx = std::min(start_idx + count, data_.size());
-    for (size_t i = start_idx; i < end_idx; i++) {
-        chunk.push_back(data_[i]);
+    return RowRange(data_).Sub(start_idx, count);
+}
+
+namespace {
+// Input bytes from `from` to the end of `chunk`. Rows sit in order in one
+// buffer, so this is a pointer difference; it bounds the text those rows can
+// produce (give or take re-quoting)
+size_t RemainingInput(RowRange chunk, const CSVRow* from) {
+    if (from == chunk.end()) {
+        return 0;
     }
-    
-    std::cout << "[DataProcessor] chunk start=" << start_idx 
-              << " requested=" << count << " actual=" << chunk.size() << std::endl;
-    return chunk;
+    const CSVRow& last = chunk[chunk.size() - 1];
+    const char* begin = from->View().data();
+    const char* end = last.View().data() + last.View().size() + 1;  // + newline
+    return end > begin ? static_cast<size_t>(end - begin) : 0;
 }
 
-std::string DataProcessor::ProcessChunk(const std::vector<CSVRow>& chunk, const std::string& filter_column, const std::string& filter_value) {
-    std::stringstream ss;
-    
-    // Add header
-    ss << header_ << "\n";
-    
-    int processed = 0; // Count of processed rows in terms of filtering
-    for (const auto& row : chunk) {
-        // Apply filter if specified
-        if (!filter_column.empty() && !filter_value.empty()) {
-            // Parse header to find column index
-            std::stringstream header_ss(header_);
-            std::string col_name;
-            int col_index = -1;
-            int current_col = 0;
-            
-            while (std::getline(header_ss, col_name, ',')) {
-                if (col_name == filter_column) {
-                    col_index = current_col;
-                    break;
+// Headroom for the row that takes a part past part_bytes
+constexpr size_t kRowSlack = 4096;
+
+// Timestamps stay text on the wire so decoded rows match the CSV output
+colbatch::Type WireType(ColumnType type) {
+    switch (type) {
+        case ColumnType::Float64: return colbatch::Type::Float64;
+        case ColumnType::Int64: return colbatch::Type::Int64;
+        case ColumnType::Int32: return colbatch::Type::Int32;
+        case ColumnType::Dictionary: return colbatch::Type::Dictionary;
+        default: return colbatch::Type::String;
+    }
+}
+}
+
+std::string DataProcessor::ProcessChunk(RowRange chunk, const std::string& filter_column, const std::string& filter_value) {
+    // Legacy single equality filter; an unknown column leaves the chunk unfiltered
+    ScanSpec spec;
+    if (!filter_column.empty() && !filter_value.empty() && schema_.Find(filter_column)) {
+        FilterPredicate pred;
+        pred.column = filter_column;
+        pred.values.push_back(filter_value);
+        CompileScan({pred}, {}, &spec, nullptr);
+    }
+    return ProcessChunk(chunk, spec);
+}
+
+std::string DataProcessor::ProcessChunk(RowRange chunk, const ScanSpec& spec) {
+    std::string out;
+    ProcessChunk(chunk, spec, std::numeric_limits<size_t>::max(),
+                 [&out](std::string&& part) { out = std::move(part); });
+    return out;
+}
+
+size_t DataProcessor::ProcessChunk(RowRange chunk, const ScanSpec& spec,
+                                   size_t part_bytes, const PartSink& emit) {
+    // No logging: this runs once per morsel on several scan threads
+    return (spec.format == OutputFormat::Columnar)
+               ? EncodeColumnar(chunk, spec, part_bytes, emit)
+               : EncodeCsv(chunk, spec, part_bytes, emit);
+}
+
+size_t DataProcessor::EncodeCsv(RowRange chunk, const ScanSpec& spec,
+                                size_t part_bytes, const PartSink& emit) const {
+    const std::string header = GetHeader(spec) + "\n";
+
+    // Each part is allocated once at about its final size (part_bytes, or
+    // what is left of the chunk if that is less) rather than doubling its way
+    // up; the finished string is moved into the WorkerResult as-is
+    auto start_part = [&](const CSVRow* next) {
+        std::string fresh;
+        fresh.reserve(header.size() + std::min(part_bytes, RemainingInput(chunk, next)) + kRowSlack);
+        fresh.append(header);
+        return fresh;
+    };
+    std::string part = start_part(chunk.begin());
+
+    const RowFilter& filter = spec.filter;
+    const bool filtering = !filter.Empty();
+    const bool projecting = !spec.projection.empty();
+    std::vector<std::string_view> fields;
+
+    size_t processed = 0;  // rows kept by the filter
+    size_t part_rows = 0;
+    bool emitted = false;
+    for (const CSVRow* it = chunk.begin(); it != chunk.end(); ++it) {
+        const CSVRow& row = *it;
+        if (filtering && !filter.Matches(row)) {
+            continue;  // Skip this row
+        }
+
+        if (projecting) {
+            csv::SplitFields(row.View(), ',', fields);
+            for (size_t i = 0; i < spec.projection.size(); ++i) {
+                if (i > 0) {
+                    part += ',';
                 }
-                current_col++;
-            }
-            
-            // Check if row matches filter
-            if (col_index >= 0) {
-                std::string field_value = row.GetField(col_index);
-                if (field_value != filter_value) {
-                    continue;  // Skip this row
+                size_t f = spec.projection[i];
+                if (f < fields.size()) {
+                    csv::AppendField(part, fields[f]);  // re-quoted if needed
                 }
             }
+            part += '\n';
+        } else {
+            // Write raw row
+            part.append(row.View());
+            part += '\n';
         }
-        
-        // Write raw row
-        ss << row.GetRaw() << "\n";
         processed++;
+        part_rows++;
+
+        if (part.size() >= part_bytes) {
+            emit(std::move(part));
+            emitted = true;
+            part = start_part(it + 1);
+            part_rows = 0;
+        }
     }
-    
-    std::cout << "[DataProcessor] processed=" << processed;
-    if (!filter_column.empty()) {
-        std::cout << " filter=" << filter_column << "=" << filter_value;
+
+    if (part_rows > 0 || !emitted) {
+        if (part.capacity() > 2 * part.size()) {
+            part.shrink_to_fit();  // filtered tail; don't keep the reservation around
+        }
+        emit(std::move(part));
     }
-    std::cout << std::endl;
-    
-    return ss.str();
+    return processed;
+}
+
+size_t DataProcessor::EncodeColumnar(RowRange chunk, const ScanSpec& spec,
+                                     size_t part_bytes, const PartSink& emit) const {
+    std::vector<size_t> selected = spec.projection;
+    if (selected.empty()) {
+        for (size_t i = 0; i < schema_.NumColumns(); ++i) {
+            selected.push_back(i);
+        }
+    }
+
+    std::vector<colbatch::Field> wire_fields;
+    for (size_t f : selected) {
+        const ColumnSpec& col = schema_.At(f);
+        wire_fields.push_back(colbatch::Field{col.name, WireType(col.type)});
+    }
+    auto writer = std::make_unique<colbatch::Writer>(wire_fields);
+
+    const RowFilter& filter = spec.filter;
+    const bool filtering = !filter.Empty();
+    std::vector<std::string_view> fields;
+    std::vector<std::string_view> values(selected.size());
+
+    size_t processed = 0;
+    bool emitted = false;
+    for (const auto& row : chunk) {
+        if (filtering && !filter.Matches(row)) {
+            continue;
+        }
+        csv::SplitFields(row.View(), ',', fields);
+        for (size_t i = 0; i < selected.size(); ++i) {
+            values[i] = selected[i] < fields.size() ? fields[selected[i]] : std::string_view();
+        }
+        writer->AppendRow(values);
+        processed++;
+
+        if (writer->ApproxBytes() >= part_bytes) {
+            emit(writer->Finish());
+            emitted = true;
+            writer = std::make_unique<colbatch::Writer>(wire_fields);
+        }
+    }
+
+    if (writer->NumRows() > 0 || !emitted) {
+        emit(writer->Finish());
+    }
+    return processed;
+}
+
+bool DataProcessor::CompileScan(const std::vector<FilterPredicate>& predicates,
+                                const std::vector<std::string>& columns, ScanSpec* spec,
+                                std::string* error) const {
+    if (!spec->filter.Compile(predicates, schema_, columns_.get(), error)) {
+        return false;
+    }
+
+    spec->projection.clear();
+    for (const auto& name : columns) {
+        int index = schema_.IndexOf(name);
+        if (index < 0) {
+            if (error) *error = "unknown column '" + name + "'";
+            return false;
+        }
+        spec->projection.push_back(static_cast<size_t>(index));
+    }
+    return true;
+}
+
+std::string DataProcessor::GetHeader(const ScanSpec& spec) const {
+    if (spec.projection.empty()) {
+        return header_;
+    }
+    std::string header;
+    for (size_t i = 0; i < spec.projection.size(); ++i) {
+        if (i > 0) {
+            header += ',';
+        }
+        header += schema_.At(spec.projection[i]).name;
+    }
+    return header;
 }
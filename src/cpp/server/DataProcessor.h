@@ -1,69 +1,181 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <functional>
+#include "CsvScanner.h"
+#include "ColumnStore.h"
+#include "Schema.h"
+#include "RowFilter.h"
 
-// Generic CSV row - just stores raw line as string
+// Generic CSV row - a view of one raw line inside the dataset buffer.
+// The bytes are owned by the DataProcessor that produced the row.
 class CSVRow {
 public:
-    CSVRow(const std::string& line) : raw_line_(line) {}
-    
-    std::string GetRaw() const { return raw_line_; }
-    
+    CSVRow() = default;
+    CSVRow(std::string_view line, size_t index) : line_(line), index_(index) {}
+
+    std::string_view View() const { return line_; }
+
+    // Position in the dataset; indexes the ColumnStore arrays
+    size_t Index() const { return index_; }
+
     // Parse specific fields if needed (0-indexed)
     std::string GetField(size_t index, char delimiter = ',') const {
-        std::stringstream ss(raw_line_);
-        std::string field;
-        size_t current_idx = 0;
-        
-        while (std::getline(ss, field, delimiter)) {
-            if (current_idx == index) {
-                return field;
-            }
-            current_idx++;
-        }
-        return "";
+        return std::string(csv::FieldAt(line_, index, delimiter));
     }
-    
+
     // Get all fields
     std::vector<std::string> GetAllFields(char delimiter = ',') const {
-        std::vector<std::string> fields;
-        std::stringstream ss(raw_line_);
-        std::string field;
-        
-        while (std::getline(ss, field, delimiter)) {
-            fields.push_back(field);
-        }
-        return fields;
+        std::vector<std::string_view> views;
+        csv::SplitFields(line_, delimiter, views);
+        return std::vector<std::string>(views.begin(), views.end());
     }
-    
+
 private:
-    std::string raw_line_;
+    std::string_view line_;
+    size_t index_ = 0;
+};
+
+// Non-owning span of consecutive rows, e.g. a slice of a DataProcessor's
+// dataset; valid as long as the rows it points at
+class RowRange {
+public:
+    RowRange() = default;
+    RowRange(const CSVRow* begin, const CSVRow* end) : begin_(begin), end_(end) {}
+    RowRange(const std::vector<CSVRow>& rows) : begin_(rows.data()), end_(rows.data() + rows.size()) {}
+
+    const CSVRow* begin() const { return begin_; }
+    const CSVRow* end() const { return end_; }
+    size_t size() const { return static_cast<size_t>(end_ - begin_); }
+    bool empty() const { return begin_ == end_; }
+    const CSVRow& operator[](size_t i) const { return begin_[i]; }
+
+    // Up to `count` rows starting at `offset`
+    RowRange Sub(size_t offset, size_t count) const {
+        offset = std::min(offset, size());
+        return RowRange(begin_ + offset, begin_ + offset + std::min(count, size() - offset));
+    }
+
+private:
+    const CSVRow* begin_ = nullptr;
+    const CSVRow* end_ = nullptr;
+};
+
+// Encoding of ProcessChunk output: CSV text, or a typed binary batch
+// (colbatch::Writer) that the client decodes without re-parsing text
+enum class OutputFormat { Csv, Columnar };
+
+// Compiled per-request scan: which rows to keep and which fields to emit
+struct ScanSpec {
+    RowFilter filter;
+    std::vector<size_t> projection;  // field indexes in output order; empty = whole row
+    OutputFormat format = OutputFormat::Csv;
 };
 
 class DataProcessor {
 public:
-    DataProcessor(const std::string& dataset_path);
-    
+    // Mmap maps the file read-only and indexes rows in place (falls back to
+    // Stream when mapping is unavailable). Stream reads the file into one
+    // owned buffer and indexes that instead.
+    enum class LoadMode { Stream, Mmap };
+
+    // load_threads = 0 uses every hardware thread for the row scan
+    DataProcessor(const std::string& dataset_path, LoadMode mode = LoadMode::Mmap,
+                  unsigned load_threads = 0);
+    ~DataProcessor();
+
+    // Rows point into the mapping/buffer, so the processor must stay put
+    DataProcessor(const DataProcessor&) = delete;
+    DataProcessor& operator=(const DataProcessor&) = delete;
+
+    // LoadDataset always dictionary-encodes the low-cardinality text columns;
+    // this also materializes the numeric ones (off by default; costs roughly
+    // 80 bytes per row on the air-quality schema)
+    void EnableColumnStore(bool enabled) { build_columns_ = enabled; }
+
     // Load entire dataset
     bool LoadDataset();
-    
-    // Get chunk of data for processing (start_idx to end_idx)
-    std::vector<CSVRow> GetChunk(size_t start_idx, size_t count);
-    
+
+    // Rows [start_idx, start_idx + count), clamped to the dataset; a view, so
+    // no row is copied
+    RowRange GetChunk(size_t start_idx, size_t count) const;
+
     // Get total row count
     size_t GetTotalRows() const { return data_.size(); }
-    
+
     // Process a chunk (returns CSV string with header + data)
-    std::string ProcessChunk(const std::vector<CSVRow>& chunk, const std::string& filter_column = "", const std::string& filter_value = "");
-    
+    std::string ProcessChunk(RowRange chunk, const std::string& filter_column = "", const std::string& filter_value = "");
+
+    // Same, keeping rows that pass spec.filter and only the projected fields
+    std::string ProcessChunk(RowRange chunk, const ScanSpec& spec);
+
+    // Receives each finished part of a scan's output
+    using PartSink = std::function<void(std::string&& part)>;
+
+    // Same, cut into parts of roughly `part_bytes` handed to `emit` as the scan
+    // goes, so only one part is buffered at a time. Every part is self-contained
+    // (own header or batch schema); at least one is emitted. Returns rows kept.
+    size_t ProcessChunk(RowRange chunk, const ScanSpec& spec,
+                        size_t part_bytes, const PartSink& emit);
+
+    // Compile predicates and a projection (column names, empty = all)
+    // against this dataset's schema and columns
+    bool CompileScan(const std::vector<FilterPredicate>& predicates,
+                     const std::vector<std::string>& columns, ScanSpec* spec,
+                     std::string* error) const;
+
+    // Header line for a scan's output
+    std::string GetHeader(const ScanSpec& spec) const;
+
     // Get header
     std::string GetHeader() const { return header_; }
-    
+
+    // Header compiled into name -> index/type, built once per load
+    const Schema& GetSchema() const { return schema_; }
+
+    // Field of `row` by column name (empty if the column does not exist)
+    std::string_view GetField(const CSVRow& row, const std::string& column) const;
+
+    // Typed columns (dictionary columns only unless EnableColumnStore(true))
+    const ColumnStore* GetColumnStore() const { return columns_.get(); }
+
 private:
+    // ProcessChunk bodies for each OutputFormat
+    size_t EncodeCsv(RowRange chunk, const ScanSpec& spec,
+                     size_t part_bytes, const PartSink& emit) const;
+    size_t EncodeColumnar(RowRange chunk, const ScanSpec& spec,
+                          size_t part_bytes, const PartSink& emit) const;
+
+    bool MapFile();
+    bool ReadFile();
+    void Unmap();
+
+    // Split [begin, end) into header_ and one CSVRow per non-empty line.
+    // The body is cut into byte ranges scanned in parallel, then merged.
+    void IndexRows(const char* begin, const char* end);
+
+    // Rows that *start* inside [range_begin, range_end); a row may run past
+    // range_end up to file_end. Indexes are relative to the range.
+    static void ScanRows(const char* range_begin, const char* range_end,
+                         const char* file_end, std::vector<CSVRow>& out);
+
     std::string dataset_path_;
+    LoadMode mode_;
+    unsigned load_threads_;
+    bool build_columns_ = false;
     std::string header_;
+    Schema schema_;
     std::vector<CSVRow> data_;
+    std::unique_ptr<ColumnStore> columns_;
+
+    // Backing bytes for data_: either a read-only mapping or buffer_
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    std::string buffer_;
 };
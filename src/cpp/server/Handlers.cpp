@@ -3,6 +3,7 @@
 #include "minitwo.grpc.pb.h"
 #include "RequestProcessor.h"
 #include "SessionManager.h"
+#include "WorkerQueue.h"
 #include <iostream>
 #include <string>
 #include <memory>
@@ -14,6 +15,19 @@ using grpc::Status;
 // Global shutdown flag
 extern std::atomic<bool> g_shutdown_requested;
 
+// Moves the fields out of a unary request so a large payload isn't copied;
+// *req is left empty. This is the one place a request is modified, and it is
+// safe only because: the sync API deserializes each request into a non-const
+// message owned by that call, gRPC doesn't read it again after the handler
+// and destroys it when the call ends, and this server registers no
+// interceptors that could see it later. Don't touch *req afterwards.
+template <typename Message>
+static Message TakeRequest(const Message* req) {
+    Message taken;
+    taken.Swap(const_cast<Message*>(req));
+    return taken;
+}
+
 class NodeControlService final : public mini2::NodeControl::Service {
 private:
     std::shared_ptr<RequestProcessor> processor_;
@@ -72,24 +86,35 @@ public:
 class TeamIngressService final : public mini2::TeamIngress::Service {
 private:
     std::shared_ptr<RequestProcessor> processor_;
+    std::shared_ptr<WorkerQueue> queue_;
     std::string node_id_;
 public:
-    TeamIngressService(std::shared_ptr<RequestProcessor> processor, const std::string& node_id) 
-        : processor_(processor), node_id_(node_id) {}
+    TeamIngressService(std::shared_ptr<RequestProcessor> processor, std::shared_ptr<WorkerQueue> queue,
+                       const std::string& node_id) 
+        : processor_(processor), queue_(queue), node_id_(node_id) {}
     
     Status HandleRequest(ServerContext* ctx, const mini2::Request* req, mini2::HeartbeatAck* resp) override {
         std::cout << "[TeamIngress] HandleRequest: " << req->request_id() 
                   << " (green=" << req->need_green() << ", pink=" << req->need_pink() << ")" << std::endl;
         
-        // Determine if this is a team leader or worker
-        if (node_id_ == "B" || node_id_ == "E") {
-            // Team leaders forward to workers or process locally
-            processor_->HandleTeamRequest(*req);
-        } else {
-            // Workers process and send results back
-            processor_->HandleWorkerRequest(*req);
-        }
+        // Ack right away; the work runs on the ingress queue so the caller's
+        // fan-out is not serialized behind this node's processing
+        auto processor = processor_;
+        const bool team_leader = (node_id_ == "B" || node_id_ == "E");
+        bool accepted = queue_->EnqueueRequest(*req, [processor, team_leader](const mini2::Request& request) {
+            if (team_leader) {
+                // Team leaders forward to workers or process locally
+                processor->HandleTeamRequest(request);
+            } else {
+                // Workers process and send results back
+                processor->HandleWorkerRequest(request);
+            }
+        });
         
+        if (!accepted) {
+            resp->set_ok(false);
+            return Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "node " + node_id_ + " is busy");
+        }
         resp->set_ok(true);
         return Status::OK;
     }
@@ -98,8 +123,9 @@ public:
         std::cout << "[TeamIngress] PushWorkerResult: " << req->request_id() 
                   << " part=" << req->part_index() << std::endl;
         
-        // Store result in processor
-        processor_->ReceiveWorkerResult(*req);
+        // Store result in processor; parts can be hundreds of MB, so the
+        // payload is moved on rather than copied
+        processor_->ReceiveWorkerResult(TakeRequest(req));
         
         resp->set_ok(true);
         return Status::OK;
@@ -122,11 +148,12 @@ public:
         return Status::OK;
     }
     
-    Status GetNext(ServerContext*, const mini2::NextChunkReq* req, mini2::NextChunkResp* resp) override {
+    Status GetNext(ServerContext* ctx, const mini2::NextChunkReq* req, mini2::NextChunkResp* resp) override {
         std::cout << "[ClientGateway] GetNext: " << req->request_id() 
                   << " index=" << req->next_index() << std::endl;
         
-        bool success = session_manager_->GetNextChunk(req->request_id(), req->next_index(), resp);
+        bool success = session_manager_->GetNextChunk(req->request_id(), req->next_index(), resp,
+                                                      req->window(), [ctx]() { return ctx->IsCancelled(); });
         
         if (!success) {
             resp->set_has_more(false);
@@ -151,20 +178,14 @@ public:
             std::cout << "[ClientGateway] background processing for session " 
                       << session_id << std::endl;
             
-            // Process request (same as RequestOnce)
-            auto results = processor_->ProcessRequest(req);
-            
-            // Add each chunk to session
-            for (const auto& result : results) {
-                mini2::WorkerResult wr;
-                wr.set_request_id(session_id);
-                wr.set_part_index(result.part_index());
-                wr.set_payload(result.payload());
-                session_manager_->AddChunk(session_id, wr);
-            }
+            // Each part goes into the session as soon as it reaches A
+            std::string error = processor_->ProcessRequest(req, [this, &session_id](mini2::WorkerResult&& result) {
+                result.set_request_id(session_id);
+                session_manager_->AddChunk(session_id, std::move(result));
+            });
             
             // Mark session complete
-            session_manager_->CompleteSession(session_id);
+            session_manager_->CompleteSession(session_id, error);
             
             std::cout << "[ClientGateway] background done for session " 
                       << session_id << std::endl;
@@ -186,6 +207,55 @@ public:
         return Status::OK;
     }
     
+    Status StreamChunks(ServerContext* ctx, const mini2::NextChunkReq* req,
+                        grpc::ServerWriter<mini2::NextChunkResp>* writer) override {
+        std::cout << "[ClientGateway] StreamChunks: " << req->request_id() 
+                  << " from=" << req->next_index() << std::endl;
+
+        // An empty stream would look like an empty result
+        if (!session_manager_->HasSession(req->request_id())) {
+            return Status(grpc::StatusCode::NOT_FOUND, "no session " + req->request_id());
+        }
+
+        uint32_t index = req->next_index();
+        auto cancelled = [ctx]() { return ctx->IsCancelled(); };
+        uint32_t sent = 0;
+        bool lost = false;
+        while (!ctx->IsCancelled()) {
+            mini2::NextChunkResp resp;
+            // Blocks until chunk `index` arrives, the session completes or
+            // the call is cancelled
+            if (!session_manager_->GetNextChunk(req->request_id(), index, &resp, 1, cancelled)) {
+                lost = !session_manager_->HasSession(req->request_id());
+                if (!lost && !resp.error().empty()) {
+                    writer->Write(resp);  // no chunk, but the client needs the error
+                }
+                break;
+            }
+            // Write blocks while the client's flow-control window is full
+            if (!writer->Write(resp)) {
+                std::cerr << "[ClientGateway] StreamChunks: client went away at chunk " << index << std::endl;
+                break;
+            }
+            index++;
+            sent++;
+            if (!resp.has_more()) {
+                break;
+            }
+        }
+
+        std::cout << "[ClientGateway] StreamChunks done: " << req->request_id() 
+                  << " sent=" << sent << std::endl;
+        if (ctx->IsCancelled()) {
+            return Status::CANCELLED;
+        }
+        if (lost) {
+            // Closed or expired mid-stream: what was sent is not the whole result
+            return Status(grpc::StatusCode::NOT_FOUND, "session " + req->request_id() + " went away");
+        }
+        return Status::OK;
+    }
+
     Status CloseSession(ServerContext*, const mini2::CloseSessionReq* req, mini2::CloseSessionResp* resp) override {
         std::cout << "[ClientGateway] CloseSession: " << req->session_id() << std::endl;
         
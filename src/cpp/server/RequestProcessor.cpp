@@ -1,4 +1,5 @@
 #include "RequestProcessor.h"
+#include "Aggregator.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -14,6 +15,54 @@
 
 namespace {
 constexpr int kMaxGrpcMessageSize = 1536 * 1024 * 1024; // 1.5GB
+constexpr size_t kDefaultPartBytes = 4 * 1024 * 1024;    // per WorkerResult part
+constexpr size_t kMinMorselRows = 16 * 1024;             // smallest unit of a parallel scan
+
+// Sources that have sent their final part
+size_t CountFinished(const std::vector<mini2::WorkerResult>& results) {
+    return static_cast<size_t>(std::count_if(results.begin(), results.end(),
+                                             [](const mini2::WorkerResult& r) { return r.last(); }));
+}
+
+std::vector<FilterPredicate> ToFilterPredicates(const mini2::Request& req) {
+    std::vector<FilterPredicate> out;
+    for (const auto& p : req.filters()) {
+        FilterPredicate pred;
+        pred.column = p.column();
+        pred.values.assign(p.values().begin(), p.values().end());
+        switch (p.op()) {
+            case mini2::Predicate::NE: pred.op = FilterPredicate::Op::Ne; break;
+            case mini2::Predicate::LT: pred.op = FilterPredicate::Op::Lt; break;
+            case mini2::Predicate::LE: pred.op = FilterPredicate::Op::Le; break;
+            case mini2::Predicate::GT: pred.op = FilterPredicate::Op::Gt; break;
+            case mini2::Predicate::GE: pred.op = FilterPredicate::Op::Ge; break;
+            case mini2::Predicate::BETWEEN: pred.op = FilterPredicate::Op::Between; break;
+            case mini2::Predicate::IN: pred.op = FilterPredicate::Op::In; break;
+            default: pred.op = FilterPredicate::Op::Eq; break;
+        }
+        out.push_back(std::move(pred));
+    }
+    return out;
+}
+
+// Fold the aggregate partials of `parts` into a single result. A part with an
+// error holds no valid partial; it is left out and its error carried over.
+mini2::WorkerResult MergeAggregateParts(const std::string& request_id,
+                                        const std::vector<mini2::WorkerResult>& parts) {
+    mini2::WorkerResult merged;
+    merged.set_request_id(request_id);
+    merged.set_part_index(0);
+    for (const auto& part : parts) {
+        if (!part.error().empty()) {
+            if (merged.error().empty()) {
+                merged.set_error(part.error());
+            }
+            continue;
+        }
+        Aggregator::Merge(part.aggregate(), merged.mutable_aggregate());
+    }
+    return merged;
+}
 
 uint64_t GetProcessMemory() {
 #if defined(__APPLE__)
@@ -50,6 +99,7 @@ RequestProcessor::RequestProcessor(const std::string& node_id)
     , shutting_down_(false)
     , requests_processed_(0)
     , start_time_(std::chrono::steady_clock::now()) {
+    SetScanThreads(0);
     std::cout << "[RequestProcessor] Node " << node_id << " ready" << std::endl;
 }
 
@@ -57,6 +107,13 @@ RequestProcessor::~RequestProcessor() {
     // Nothing to clean up beyond automatic members
 }
 
+void RequestProcessor::SetScanThreads(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    scan_threads_ = static_cast<size_t>(std::max(1, threads));
+}
+
 void RequestProcessor::SetTeamLeaders(const std::vector<std::pair<std::string, std::string>>& team_leader_endpoints) {
     for (const auto& [role, addr] : team_leader_endpoints) {
         RegisterPeer(addr, team_leader_stubs_, "team leader");
@@ -91,6 +148,7 @@ void RequestProcessor::LoadDataset(const std::string& dataset_path) {
     
     std::cout << "[RequestProcessor] Loading dataset: " << dataset_path << std::endl;
     data_processor_ = std::make_unique<DataProcessor>(dataset_path);
+    data_processor_->EnableColumnStore(column_store_enabled_);
     if (!data_processor_->LoadDataset()) {
         std::cerr << "[RequestProcessor] ERROR: Failed to load dataset" << std::endl;
         data_processor_ = nullptr;
@@ -125,13 +183,20 @@ void RequestProcessor::LoadDatasetIfNeeded(const mini2::Request& request) {
 // Process A: Leader Request Handling
 // ============================================================================
 
-std::vector<mini2::WorkerResult> RequestProcessor::ProcessRequest(const mini2::Request& request) {
+std::vector<mini2::WorkerResult> RequestProcessor::ProcessRequest(const mini2::Request& request, std::string* error) {
     std::cout << "[Leader] request: " << request.request_id() 
               << " green=" << request.need_green() 
-              << " pink=" << request.need_pink() << std::endl;
+              << " pink=" << request.need_pink() 
+              << " filters=" << request.filters_size() << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        collecting_.insert(request.request_id());
+    }
 
     // Forward to team leaders
-    int expected_results = ForwardToTeamLeaders(request, request.need_green(), request.need_pink());
+    std::string refused;
+    int expected_results = ForwardToTeamLeaders(request, request.need_green(), request.need_pink(), &refused);
     
     std::cout << "[Leader] waiting for " << expected_results << " team-leader result(s)" << std::endl;
 
@@ -139,39 +204,102 @@ std::vector<mini2::WorkerResult> RequestProcessor::ProcessRequest(const mini2::R
     std::unique_lock<std::mutex> lock(results_mutex_);
     bool got_results = results_cv_.wait_for(lock, std::chrono::seconds(90), [this, &request, expected_results]() {
         return pending_results_.count(request.request_id()) && 
-               pending_results_[request.request_id()].size() >= static_cast<size_t>(expected_results);
+               CountFinished(pending_results_[request.request_id()]) >= static_cast<size_t>(expected_results);
     });
     
+    std::string incomplete = refused;
     if (!got_results) {
+        incomplete = "timed out waiting for team leaders";
         std::cerr << "[Leader] WARNING: Timeout waiting for results from team leaders" << std::endl;
     } else {
         std::cout << "[Leader] received all expected results" << std::endl;
     }
 
-    // Collect results (lock already held from wait_for)
+    // Collect results (lock already held from wait_for); stragglers are
+    // dropped from here on
     std::vector<mini2::WorkerResult> results;
+    collecting_.erase(request.request_id());
     
     if (pending_results_.count(request.request_id())) {
-        results = pending_results_[request.request_id()];
+        results = std::move(pending_results_[request.request_id()]);
         pending_results_.erase(request.request_id());
     } else {
         // Fallback if results not received in time
         std::cerr << "[Leader] WARNING: No results received for " << request.request_id() 
                   << ", returning empty" << std::endl;
     }
+    for (const auto& result : results) {
+        if (incomplete.empty() && !result.error().empty()) {
+            incomplete = result.error();
+        }
+    }
 
-    std::cout << "[Leader] done: " << request.request_id() 
-              << " chunks=" << results.size() << std::endl;
+    if (request.has_aggregate()) {
+        // Team partials -> final groups, rendered once here
+        mini2::WorkerResult merged = MergeAggregateParts(request.request_id(), results);
+        merged.set_payload(Aggregator::Render(request.aggregate(), merged.aggregate()));
+        std::cout << "[Leader] aggregated " << results.size() << " partial(s) into "
+                  << merged.aggregate().groups_size() << " group(s)" << std::endl;
+        results.clear();
+        results.push_back(std::move(merged));
+    }
 
+    std::cout << "[Leader] done: " << request.request_id() 
+              << " chunks=" << results.size() << (incomplete.empty() ? "" : " (incomplete)") << std::endl;
+    if (error) {
+        *error = incomplete;
+    }
     return results;
 }
 
-int RequestProcessor::ForwardToTeamLeaders(const mini2::Request& req, bool need_green, bool need_pink) {
-    int forwarded = 0;
+std::string RequestProcessor::ProcessRequest(const mini2::Request& request, const ResultSink& sink) {
+    if (request.has_aggregate()) {
+        // Partials have to be merged before anything can go out
+        std::string error;
+        for (auto& result : ProcessRequest(request, &error)) {
+            sink(std::move(result));
+        }
+        return error;
+    }
+
+    std::cout << "[Leader] request: " << request.request_id() 
+              << " green=" << request.need_green() 
+              << " pink=" << request.need_pink() 
+              << " filters=" << request.filters_size() << " (relay)" << std::endl;
+
+    // Parts go straight to `sink` from ReceiveWorkerResult as team leaders push them
+    auto relay = OpenRelay(request.request_id(), sink);
+    std::string refused;
+    int expected_results = ForwardToTeamLeaders(request, request.need_green(), request.need_pink(), &refused);
+
+    std::cout << "[Leader] waiting for " << expected_results << " team leader(s) to finish" << std::endl;
+
+    std::unique_lock<std::mutex> lock(results_mutex_);
+    bool finished = WaitForResults(lock, std::chrono::seconds(90), relay, [&relay, expected_results]() {
+        return relay->finished >= static_cast<size_t>(expected_results);
+    });
+    lock.unlock();
+    CloseRelay(request.request_id());
+
+    std::string incomplete = refused;
+    if (!finished) {
+        incomplete = "timed out waiting for team leaders";
+        std::cerr << "[Leader] WARNING: Timeout waiting for results from team leaders" << std::endl;
+    } else if (incomplete.empty()) {
+        lock.lock();
+        incomplete = relay->error;
+        lock.unlock();
+    }
+    std::cout << "[Leader] done: " << request.request_id() 
+              << " chunks=" << relay->next_seq 
+              << (incomplete.empty() ? "" : " (incomplete)") << std::endl;
+    return incomplete;
+}
+
+int RequestProcessor::ForwardToTeamLeaders(const mini2::Request& req, bool need_green, bool need_pink,
+                                           std::string* error) {
+    std::vector<std::pair<std::string, mini2::TeamIngress::Stub*>> targets;
     for (auto& [addr, stub] : team_leader_stubs_) {
-        ClientContext ctx;
-        mini2::HeartbeatAck ack;
-        
         const auto role_it = team_leader_roles_.find(addr);
         const std::string role = (role_it != team_leader_roles_.end()) ? role_it->second : "";
         const bool should_call =
@@ -180,20 +308,67 @@ int RequestProcessor::ForwardToTeamLeaders(const mini2::Request& req, bool need_
             role.empty();
 
         if (should_call) {
-            Status status = stub->HandleRequest(&ctx, req, &ack);
-            if (status.ok()) {
-                std::cout << "[Leader] Forwarded to team leader: " << addr << std::endl;
-                forwarded++;
-            } else {
-                std::cerr << "[Leader] Failed to forward to " << addr << ": " 
-                         << status.error_message() << std::endl;
-            }
+            targets.emplace_back(addr, stub.get());
         }
     }
+
+    int forwarded = ForwardToPeers(req, targets, "Leader", "team leader", error);
     std::cout << "[Leader] Forwarded request to " << forwarded << " team leader(s)" << std::endl;
     return forwarded;
 }
 
+int RequestProcessor::ForwardToPeers(const mini2::Request& req,
+                                     const std::vector<std::pair<std::string, mini2::TeamIngress::Stub*>>& targets,
+                                     const std::string& role, const char* peer_label, std::string* error) {
+    // One thread per peer so the teams start at the same time; each call
+    // only waits for the peer's ack. A peer whose queue is full says so
+    // with RESOURCE_EXHAUSTED and is asked again after a growing pause.
+    constexpr int kAttempts = 5;
+    std::vector<char> ok(targets.size(), 0);
+    std::vector<std::string> failures(targets.size());
+    std::vector<std::thread> calls;
+    calls.reserve(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        calls.emplace_back([&, i]() {
+            auto backoff = std::chrono::milliseconds(100);
+            for (int attempt = 1; ; ++attempt) {
+                ClientContext ctx;
+                ctx.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+                mini2::HeartbeatAck ack;
+                Status status = targets[i].second->HandleRequest(&ctx, req, &ack);
+                if (status.ok()) {
+                    ok[i] = 1;
+                    return;
+                }
+                if (status.error_code() != grpc::StatusCode::RESOURCE_EXHAUSTED || attempt == kAttempts) {
+                    failures[i] = status.error_message();
+                    std::cerr << "[" << role << "] Failed to forward to " << targets[i].first << ": " 
+                             << failures[i] << std::endl;
+                    return;
+                }
+                std::cout << "[" << role << "] " << targets[i].first << " busy, retrying in " 
+                          << backoff.count() << " ms" << std::endl;
+                std::this_thread::sleep_for(backoff);
+                backoff *= 2;
+            }
+        });
+    }
+    for (auto& call : calls) {
+        call.join();
+    }
+
+    int forwarded = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (ok[i]) {
+            std::cout << "[" << role << "] Forwarded to " << peer_label << ": " << targets[i].first << std::endl;
+            forwarded++;
+        } else if (error && error->empty()) {
+            *error = std::string(peer_label) + " " + targets[i].first + " did not take the request: " + failures[i];
+        }
+    }
+    return forwarded;
+}
+
 // ============================================================================
 // Team Leaders: Request Forwarding
 // ============================================================================
@@ -204,28 +379,87 @@ void RequestProcessor::HandleTeamRequest(const mini2::Request& request) {
     LoadDatasetIfNeeded(request);
     auto proc = GetDataProcessor();
 
+    // Row results are passed on to A as each part arrives; aggregate partials
+    // are buffered so the team sends one merged partial
+    std::shared_ptr<Relay> relay;
+    if (leader_stub_ && !request.has_aggregate()) {
+        relay = OpenRelay(request.request_id(), [this](mini2::WorkerResult&& result) {
+            PushToLeader(result, "TeamLeader");
+        });
+    }
+
+    // Parts made here go where the workers' parts would have gone
+    ResultSink local_sink;
+    if (relay) {
+        local_sink = [this, relay](mini2::WorkerResult&& result) {
+            if (!result.error().empty()) {
+                std::lock_guard<std::mutex> lock(results_mutex_);
+                if (relay->error.empty()) {
+                    relay->error = result.error();
+                }
+            }
+            if (!result.payload().empty()) {
+                std::lock_guard<std::mutex> send_lock(relay->send_mutex);
+                SendRelayed(*relay, std::move(result));
+            }
+        };
+    } else {
+        local_sink = [this](mini2::WorkerResult&& result) {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            const std::string request_id = result.request_id();
+            pending_results_[request_id].push_back(std::move(result));
+        };
+    }
+
     constexpr uint32_t kLocalPartitions = 2;
     const bool can_delegate = (proc != nullptr) && !worker_stubs_.empty();
+    std::string incomplete;  // why this team's output is partial, if it is
 
     if (can_delegate) {
         std::cout << "[TeamLeader " << node_id_ << "] forwarding to " 
               << worker_stubs_.size() << " worker(s)" << std::endl;
-        int expected_workers = ForwardToWorkers(request);
+        if (!relay) {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            collecting_.insert(request.request_id());
+        }
+        int expected_workers = ForwardToWorkers(request, &incomplete);
         
         std::cout << "[TeamLeader " << node_id_ << "] waiting for " << expected_workers 
                   << " worker result(s)" << std::endl;
 
         std::unique_lock<std::mutex> lock(results_mutex_);
-        bool got_results = results_cv_.wait_for(lock, std::chrono::seconds(60), [this, &request, expected_workers]() {
+        bool got_results = WaitForResults(lock, std::chrono::seconds(60), relay, [this, &request, &relay, expected_workers]() {
+            if (relay) {
+                return relay->finished >= static_cast<size_t>(expected_workers);
+            }
             return pending_results_.count(request.request_id()) && 
-                   pending_results_[request.request_id()].size() >= static_cast<size_t>(expected_workers);
+                   CountFinished(pending_results_[request.request_id()]) >= static_cast<size_t>(expected_workers);
         });
         
         if (!got_results) {
-            std::cerr << "[TeamLeader " << node_id_ << "] WARNING: Timeout waiting for worker results, processing locally"
-                      << std::endl;
+            // Whatever the workers still send is dropped from here on
+            if (!relay) {
+                collecting_.erase(request.request_id());
+                pending_results_.erase(request.request_id());  // redone below
+            }
             lock.unlock();
-            ProcessLocally(proc, request, kLocalPartitions);
+            if (relay) {
+                CloseRelay(request.request_id());
+            }
+
+            const uint32_t relayed = relay ? relay->next_seq.load() : 0;
+            if (relayed > 0) {
+                // Those rows are already on their way to the client; doing
+                // the whole slice again here would send them twice
+                incomplete = "timed out waiting for workers after relaying " + std::to_string(relayed) + " part(s)";
+                std::cerr << "[TeamLeader " << node_id_ << "] WARNING: " << incomplete 
+                          << ", finishing with a partial result" << std::endl;
+            } else {
+                std::cerr << "[TeamLeader " << node_id_ << "] WARNING: Timeout waiting for worker results, processing locally"
+                          << std::endl;
+                incomplete.clear();  // the whole slice is redone
+                ProcessLocally(proc, request, kLocalPartitions, local_sink);
+            }
         } else {
             std::cout << "[TeamLeader " << node_id_ << "] got all " << expected_workers 
                       << " worker result(s)" << std::endl;
@@ -234,49 +468,80 @@ void RequestProcessor::HandleTeamRequest(const mini2::Request& request) {
     } else {
         std::cout << "[TeamLeader " << node_id_ << "] processing locally (dataset=" 
               << (proc ? "yes" : "no") << ", workers=" << worker_stubs_.size() << ")" << std::endl;
-        ProcessLocally(proc, request, kLocalPartitions);
+        ProcessLocally(proc, request, kLocalPartitions, local_sink);
     }
 
     std::cout << "[TeamLeader " << node_id_ << "] done: " << request.request_id() << std::endl;
+
+    if (relay) {
+        // Everything has been relayed already; tell A this team is finished.
+        // Taking send_mutex orders the marker after any part still in flight.
+        CloseRelay(request.request_id());
+        if (incomplete.empty()) {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            incomplete = relay->error;  // passed on from a worker
+        }
+        std::lock_guard<std::mutex> send_lock(relay->send_mutex);
+        mini2::WorkerResult marker;
+        marker.set_request_id(request.request_id());
+        marker.set_source(node_id_);
+        marker.set_seq(relay->next_seq);
+        marker.set_last(true);
+        marker.set_error(incomplete);
+        PushToLeader(marker, "TeamLeader");
+        return;
+    }
     
     // Send results back to Process A (Leader)
     if (leader_stub_) {
         std::cout << "[TeamLeader " << node_id_ << "] sending results to leader" << std::endl;
-        std::lock_guard<std::mutex> lock(results_mutex_);
-        auto& results = pending_results_[request.request_id()];
-        for (const auto& result : results) {
-            ClientContext ctx;
-            mini2::HeartbeatAck ack;
-            Status status = leader_stub_->PushWorkerResult(&ctx, result, &ack);
-            if (status.ok()) {
-                std::cout << "[TeamLeader " << node_id_ << "] sent part " 
-                             << result.part_index() << " to leader" << std::endl;
-            } else {
-                std::cerr << "[TeamLeader " << node_id_ << "] Failed to send result: " 
-                         << status.error_message() << std::endl;
-            }
+        std::vector<mini2::WorkerResult> results;
+        {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            results = std::move(pending_results_[request.request_id()]);
+            pending_results_.erase(request.request_id());
+            collecting_.erase(request.request_id());
+        }
+        if (request.has_aggregate() && results.size() > 1) {
+            // One partial per team instead of one per worker
+            results.assign(1, MergeAggregateParts(request.request_id(), results));
+        }
+        if (!incomplete.empty()) {
+            // A part of its own, so A still merges what the team did produce
+            mini2::WorkerResult marker;
+            marker.set_request_id(request.request_id());
+            marker.set_error(incomplete);
+            results.push_back(std::move(marker));
+        }
+        if (results.empty()) {
+            // Still tell A this team is finished
+            mini2::WorkerResult marker;
+            marker.set_request_id(request.request_id());
+            results.push_back(std::move(marker));
+        }
+        // Re-number as this team's parts; A counts one `last` per team
+        for (size_t i = 0; i < results.size(); ++i) {
+            auto& result = results[i];
+            result.set_source(node_id_);
+            result.set_seq(static_cast<uint32_t>(i));
+            result.set_last(i + 1 == results.size());
+            PushToLeader(result, "TeamLeader");
         }
-        pending_results_.erase(request.request_id());
     } else {
         std::cout << "[TeamLeader " << node_id_ << "] WARNING: leader stub not configured" << std::endl;
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        pending_results_.erase(request.request_id());
+        collecting_.erase(request.request_id());
     }
 }
 
-int RequestProcessor::ForwardToWorkers(const mini2::Request& req) {
-    int forwarded = 0;
+int RequestProcessor::ForwardToWorkers(const mini2::Request& req, std::string* error) {
+    std::vector<std::pair<std::string, mini2::TeamIngress::Stub*>> targets;
     for (auto& [addr, stub] : worker_stubs_) {
-        ClientContext ctx;
-        mini2::HeartbeatAck ack;
-        
-        Status status = stub->HandleRequest(&ctx, req, &ack);
-        if (status.ok()) {
-            std::cout << "[TeamLeader " << node_id_ << "] Forwarded to worker: " << addr << std::endl;
-            forwarded++;
-        } else {
-            std::cerr << "[TeamLeader " << node_id_ << "] Failed to forward to " << addr << ": " 
-                     << status.error_message() << std::endl;
-        }
+        targets.emplace_back(addr, stub.get());
     }
+
+    int forwarded = ForwardToPeers(req, targets, "TeamLeader " + node_id_, "worker", error);
     std::cout << "[TeamLeader " << node_id_ << "] Forwarded request to " << forwarded << " worker(s)" << std::endl;
     return forwarded;
 }
@@ -288,85 +553,253 @@ int RequestProcessor::ForwardToWorkers(const mini2::Request& req) {
 void RequestProcessor::HandleWorkerRequest(const mini2::Request& request) {
     std::cout << "[Worker " << node_id_ << "] request: " << request.request_id() << std::endl;
 
-    // Generate result and send back to team leader
-    auto result = GenerateWorkerResult(request);
-    
-    // Send result back to team leader via PushWorkerResult
-    if (leader_stub_) {
-        ClientContext ctx;
-        mini2::HeartbeatAck ack;
-        Status status = leader_stub_->PushWorkerResult(&ctx, result, &ack);
-        if (status.ok()) {
-            std::cout << "[Worker " << node_id_ << "] Sent result to team leader" << std::endl;
-        } else {
-            std::cerr << "[Worker " << node_id_ << "] Failed to send result: " 
-                     << status.error_message() << std::endl;
-        }
+    // Send each part back to the team leader as soon as it is produced
+    GenerateWorkerResult(request, [this](mini2::WorkerResult&& result) {
+        PushToLeader(result, "Worker");
+    });
+}
+
+void RequestProcessor::PushToLeader(const mini2::WorkerResult& result, const char* role) {
+    if (!leader_stub_) {
+        return;
+    }
+    // A push legitimately blocks while the client is behind (session
+    // backpressure on A), but never longer than it takes A to drop a session
+    // nobody reads: 5 minutes idle plus a cleanup pass. Past that the
+    // leader is stuck and the part is given up on.
+    ClientContext ctx;
+    ctx.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(420));
+    mini2::HeartbeatAck ack;
+    Status status = leader_stub_->PushWorkerResult(&ctx, result, &ack);
+    if (status.ok()) {
+        std::cout << "[" << role << " " << node_id_ << "] sent part " << result.part_index() 
+                  << "." << result.seq() << (result.last() ? " (last)" : "") << " upstream" << std::endl;
+    } else {
+        std::cerr << "[" << role << " " << node_id_ << "] Failed to send result: " 
+                 << status.error_message() << std::endl;
     }
 }
 
-mini2::WorkerResult RequestProcessor::GenerateWorkerResult(const mini2::Request& request) {
+void RequestProcessor::GenerateWorkerResult(const mini2::Request& request, const ResultSink& sink) {
     std::cout << "[Worker " << node_id_ << "] generating result for: " << request.request_id() << std::endl;
 
     LoadDatasetIfNeeded(request);
     auto proc = GetDataProcessor();
+    const int worker_num = (node_id_ == "C" ? 0 : (node_id_ == "D" ? 1 : 2)); // C=0, D=1, F=2
     
-    if (proc) {
-        // Process real data
-        size_t total_rows = proc->GetTotalRows();
-        const int worker_num = (node_id_ == "C" ? 0 : (node_id_ == "D" ? 1 : 2)); // C=0, D=1, F=2
-        const size_t worker_count = 3;
-
-        if (total_rows == 0) {
-            mini2::WorkerResult empty;
-            empty.set_request_id(request.request_id());
-            empty.set_part_index(worker_num);
-            return empty;
-        }
-
-        size_t rows_per_worker = std::max<size_t>(1, total_rows / worker_count);
-        size_t start_idx = static_cast<size_t>(worker_num) * rows_per_worker;
-        if (start_idx >= total_rows) {
-            start_idx = total_rows - 1;
-        }
-
-        size_t remaining = total_rows - start_idx;
-        size_t count = (worker_num == worker_count - 1)
-                           ? remaining
-                           : std::min(rows_per_worker, remaining);
-
-        return ProcessRealData(proc, request, start_idx, count);
-    } else {
-        // No dataset loaded
+    if (!proc || proc->GetTotalRows() == 0) {
+        // No dataset loaded (or empty): a single empty final part
         mini2::WorkerResult empty;
         empty.set_request_id(request.request_id());
-        empty.set_part_index(0);
-        return empty;
+        empty.set_part_index(proc ? worker_num : 0);
+        empty.set_source(node_id_);
+        empty.set_last(true);
+        sink(std::move(empty));
+        return;
     }
+
+    // Process real data
+    size_t total_rows = proc->GetTotalRows();
+    const size_t worker_count = 3;
+
+    size_t rows_per_worker = std::max<size_t>(1, total_rows / worker_count);
+    size_t start_idx = static_cast<size_t>(worker_num) * rows_per_worker;
+    if (start_idx >= total_rows) {
+        start_idx = total_rows - 1;
+    }
+
+    size_t remaining = total_rows - start_idx;
+    size_t count = (worker_num == worker_count - 1)
+                       ? remaining
+                       : std::min(rows_per_worker, remaining);
+
+    ProcessRealData(proc, request, start_idx, count, sink);
 }
 
-mini2::WorkerResult RequestProcessor::ProcessRealData(std::shared_ptr<DataProcessor> processor, const mini2::Request& req, size_t start_idx, size_t count) {
+void RequestProcessor::ProcessRealData(std::shared_ptr<DataProcessor> processor, const mini2::Request& req,
+                                       size_t start_idx, size_t count, const ResultSink& sink) {
     std::cout << "[" << node_id_ << "] real-data chunk start=" << start_idx 
               << " count=" << count << std::endl;
     
-    mini2::WorkerResult result;
-    result.set_request_id(req.request_id());
-    result.set_part_index(start_idx / count); // Simple part index calculation
+    const uint32_t part_index = static_cast<uint32_t>(start_idx / count); // Simple part index calculation
+    auto make_result = [&](uint32_t seq) {
+        mini2::WorkerResult result;
+        result.set_request_id(req.request_id());
+        result.set_part_index(part_index);
+        result.set_source(node_id_);
+        result.set_seq(seq);
+        return result;
+    };
     
-    // Get data chunk
-    auto chunk = processor->GetChunk(start_idx, count);
-    
-    // Process chunk (filter by parameter if specified in request)
-    std::string filter_param = ""; // Could extract from request if needed
-    std::string processed = processor->ProcessChunk(chunk, filter_param);
-    
-    // Set payload
-    result.set_payload(processed);
+    // Compile the pushed-down predicates and projection against this dataset
+    ScanSpec spec;
+    std::string scan_error;
+    std::vector<std::string> columns(req.columns().begin(), req.columns().end());
+    const bool compiled = processor->CompileScan(ToFilterPredicates(req), columns, &spec, &scan_error);
+    if (req.format() == mini2::Request::COLUMNAR) {
+        spec.format = OutputFormat::Columnar;
+    }
+    if (!compiled) {
+        std::cerr << "[" << node_id_ << "] bad query: " << scan_error 
+                  << ", returning no rows" << std::endl;
+        // Still an empty result in the requested format, but flagged so it
+        // can't pass for a filter that matched nothing
+        ScanSpec empty;
+        empty.format = spec.format;
+        mini2::WorkerResult result = make_result(0);
+        if (!req.has_aggregate()) {
+            processor->ProcessChunk(RowRange(), empty, kDefaultPartBytes,
+                                    [&result](std::string&& part) { result.set_payload(std::move(part)); });
+        }
+        result.set_error("bad query: " + scan_error);
+        result.set_last(true);
+        sink(std::move(result));
+        return;
+    }
+
+    // Split the slice into morsels; scan threads claim the next unscanned
+    // morsel until none are left, so a slow morsel doesn't idle the others.
+    // Morsels are views into the dataset, nothing is copied.
+    const RowRange slice = processor->GetChunk(start_idx, count);
+    const size_t threads = std::max<size_t>(1, scan_threads_);
+    const size_t morsel_rows = (threads == 1) ? std::max<size_t>(1, slice.size())
+                                              : std::max(kMinMorselRows, (slice.size() + threads * 4 - 1) / (threads * 4));
+    const size_t morsels = std::max<size_t>(1, (slice.size() + morsel_rows - 1) / morsel_rows);
+    std::atomic<size_t> next_morsel{0};
+    auto morsel_chunk = [&](size_t m) { return slice.Sub(m * morsel_rows, morsel_rows); };
+    auto run_scan = [&](const std::function<void()>& body) {
+        std::vector<std::thread> helpers;
+        for (size_t t = 1; t < std::min(threads, morsels); ++t) {
+            helpers.emplace_back(body);
+        }
+        body();
+        for (auto& h : helpers) {
+            h.join();
+        }
+    };
+
+    if (req.has_aggregate()) {
+        // Ship a partial aggregate instead of rows; each scan thread builds
+        // its own groups and they are merged at the end
+        mini2::WorkerResult result = make_result(0);
+        result.set_last(true);
+        Aggregator probe;
+        if (!probe.Compile(req.aggregate(), *processor, &scan_error)) {
+            std::cerr << "[" << node_id_ << "] bad aggregate: " << scan_error << std::endl;
+            result.set_error("bad aggregate: " + scan_error);  // no partial to merge
+            sink(std::move(result));
+            return;
+        }
+        std::mutex merge_mutex;
+        run_scan([&]() {
+            Aggregator aggregator;
+            aggregator.Compile(req.aggregate(), *processor, nullptr);
+            for (size_t m; (m = next_morsel++) < morsels;) {
+                aggregator.AccumulateChunk(morsel_chunk(m), spec.filter);
+            }
+            mini2::AggregateState partial;
+            aggregator.ToState(&partial);
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            Aggregator::Merge(partial, result.mutable_aggregate());
+        });
+        std::cout << "[" << node_id_ << "] aggregated " << slice.size() << " rows in " << morsels
+                  << " morsel(s) into " << result.aggregate().groups_size() << " group(s) for part "
+                  << part_index << std::endl;
+        sink(std::move(result));
+        return;
+    }
     
-    std::cout << "[" << node_id_ << "] generated " << processed.size() 
-              << " bytes for part " << result.part_index() << std::endl;
+    // Process morsels; only matching rows and requested columns leave this
+    // node, in parts of about part_bytes. Parts go out in row order: a morsel
+    // that finishes early waits until the ones before it have been sent. One
+    // part is held back so the final one can be flagged last.
+    const size_t part_bytes = req.part_bytes() > 0 ? req.part_bytes() : kDefaultPartBytes;
+    mini2::WorkerResult held;
+    bool holding = false;
+    uint32_t seq = 0;
+    uint64_t bytes = 0;
+    auto emit_part = [&](std::string&& part) {
+        if (holding) {
+            sink(std::move(held));
+        }
+        bytes += part.size();
+        held = make_result(seq++);
+        held.set_payload(std::move(part));
+        holding = true;
+    };
+
+    struct MorselOutput {
+        bool done = false;
+        std::vector<std::string> parts;
+    };
+    // A thread may not start a morsel more than claim_window past the oldest
+    // unsent one, so at most that many morsels' parts wait here for a slow
+    // one ahead of them instead of the whole slice.
+    // The sink can block (an RPC upstream, or session backpressure), so it
+    // is never called under emit_mutex: one thread at a time is the emitter
+    // and sends ready morsels in order while the others keep scanning and
+    // just publish theirs.
+    const size_t claim_window = threads * 2;
+    std::vector<MorselOutput> outputs(morsels);
+    std::mutex emit_mutex;
+    std::condition_variable emit_cv;
+    size_t next_emit = 0;   // morsels before this have been sent
+    bool emitting = false;
+    size_t kept_rows = 0;
+    run_scan([&]() {
+        for (size_t m; (m = next_morsel++) < morsels;) {
+            {
+                std::unique_lock<std::mutex> lock(emit_mutex);
+                emit_cv.wait(lock, [&]() { return m < next_emit + claim_window; });
+            }
+            std::vector<std::string> parts;
+            size_t kept = processor->ProcessChunk(morsel_chunk(m), spec, part_bytes,
+                                                  [&parts](std::string&& part) { parts.push_back(std::move(part)); });
+            if (kept == 0) {
+                parts.clear();  // header-only; not worth a part
+            }
+
+            std::unique_lock<std::mutex> lock(emit_mutex);
+            kept_rows += kept;
+            outputs[m].parts = std::move(parts);
+            outputs[m].done = true;
+            if (emitting) {
+                continue;  // the emitter picks it up when its turn comes
+            }
+            emitting = true;
+            while (next_emit < morsels && outputs[next_emit].done) {
+                std::vector<std::string> ready = std::move(outputs[next_emit].parts);
+                lock.unlock();
+                for (auto& part : ready) {
+                    emit_part(std::move(part));
+                }
+                lock.lock();
+                ++next_emit;
+                emit_cv.notify_all();
+            }
+            emitting = false;
+        }
+    });
+
+    if (!holding) {
+        // Nothing matched: still send the (empty) result in the right format
+        processor->ProcessChunk(RowRange(), spec, part_bytes, emit_part);
+    }
+    held.set_last(true);
+    sink(std::move(held));
     
-    return result;
+    std::cout << "[" << node_id_ << "] kept " << kept_rows << " of " << slice.size() << " row(s)";
+    if (!spec.filter.Empty()) {
+        std::cout << " filter=" << spec.filter.Describe();
+    }
+    if (!spec.projection.empty()) {
+        std::cout << " columns=" << spec.projection.size();
+    }
+    if (spec.format == OutputFormat::Columnar) {
+        std::cout << " format=columnar";
+    }
+    std::cout << ", generated " << bytes << " bytes in " << seq << " part(s) from "
+              << morsels << " morsel(s) for part " << part_index << std::endl;
 }
 
 
@@ -397,7 +830,8 @@ void RequestProcessor::RegisterPeer(const std::string& addr,
 
 
 
-void RequestProcessor::ProcessLocally(std::shared_ptr<DataProcessor> processor, const mini2::Request& request, uint32_t partitions) {
+void RequestProcessor::ProcessLocally(std::shared_ptr<DataProcessor> processor, const mini2::Request& request,
+                                      uint32_t partitions, const ResultSink& sink) {
     const uint32_t parts = std::max<uint32_t>(1, partitions);
 
     if (processor) {
@@ -418,11 +852,7 @@ void RequestProcessor::ProcessLocally(std::shared_ptr<DataProcessor> processor,
             size_t remaining = total_rows - start_idx;
             size_t count = (i == parts - 1) ? remaining : std::min(rows_per_part, remaining);
             
-            // Process chunk
-            mini2::WorkerResult result = ProcessRealData(processor, request, start_idx, count);
-            
-            // Store result locally
-            ReceiveWorkerResult(result);
+            ProcessRealData(processor, request, start_idx, count, sink);
         }
     }
 }
@@ -431,15 +861,107 @@ void RequestProcessor::ProcessLocally(std::shared_ptr<DataProcessor> processor,
 // Team Leaders: Result Collection
 // ============================================================================
 
-void RequestProcessor::ReceiveWorkerResult(const mini2::WorkerResult& result) {
+void RequestProcessor::ReceiveWorkerResult(mini2::WorkerResult&& result) {
+    std::shared_ptr<Relay> relay;
+    {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        auto it = relays_.find(result.request_id());
+        if (it == relays_.end()) {
+            if (!collecting_.count(result.request_id())) {
+                // The request finished or timed out; nobody would read this
+                std::cerr << "[" << node_id_ << "] dropping late result for " << result.request_id() 
+                          << " from=" << result.source() << " seq=" << result.seq() << std::endl;
+                return;
+            }
+            std::cout << "[TeamLeader " << node_id_ << "] Received worker result for: " 
+                      << result.request_id() << " part=" << result.part_index() 
+                      << " from=" << result.source() << " seq=" << result.seq()
+                      << (result.last() ? " last" : "") << std::endl;
+            
+            const std::string request_id = result.request_id();
+            pending_results_[request_id].push_back(std::move(result));
+            
+            // Notify waiting threads that a result arrived
+            results_cv_.notify_all();
+            return;
+        }
+        relay = it->second;
+    }
+
+    // Pass the part on right away (in arrival order); empty final markers
+    // only count towards completion
+    const bool last = result.last();
+    const std::string source = result.source();
+    const std::string error = result.error();
+    {
+        std::lock_guard<std::mutex> send_lock(relay->send_mutex);
+        if (relay->closed) {
+            std::cerr << "[" << node_id_ << "] dropping late result for " << result.request_id() 
+                      << " from=" << source << " seq=" << result.seq() << std::endl;
+            return;
+        }
+        if (!result.payload().empty()) {
+            SendRelayed(*relay, std::move(result));
+        }
+    }
+
+    if (last) {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        relay->finished++;
+        if (!error.empty()) {
+            if (relay->error.empty()) {
+                relay->error = error;
+            }
+            std::cerr << "[" << node_id_ << "] WARNING: " << source << " reported an error: " 
+                      << error << std::endl;
+        }
+        results_cv_.notify_all();
+    }
+}
+
+void RequestProcessor::SendRelayed(Relay& relay, mini2::WorkerResult&& result) {
+    result.set_source(node_id_);
+    result.set_seq(relay.next_seq++);
+    result.set_last(false);
+    relay.sending = true;
+    relay.sink(std::move(result));
+    relay.sending = false;
+}
+
+std::shared_ptr<RequestProcessor::Relay> RequestProcessor::OpenRelay(const std::string& request_id, ResultSink sink) {
+    auto relay = std::make_shared<Relay>();
+    relay->sink = std::move(sink);
     std::lock_guard<std::mutex> lock(results_mutex_);
-    pending_results_[result.request_id()].push_back(result);
-    
-    std::cout << "[TeamLeader " << node_id_ << "] Received worker result for: " 
-              << result.request_id() << " part=" << result.part_index() << std::endl;
-    
-    // Notify waiting threads that a result arrived
-    results_cv_.notify_all();
+    relays_[request_id] = relay;
+    return relay;
+}
+
+void RequestProcessor::CloseRelay(const std::string& request_id) {
+    std::shared_ptr<Relay> relay;
+    {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        auto it = relays_.find(request_id);
+        if (it == relays_.end()) {
+            return;
+        }
+        relay = it->second;
+        relays_.erase(it);
+    }
+    // A part already past the lookup waits for send_mutex and sees this
+    std::lock_guard<std::mutex> send_lock(relay->send_mutex);
+    relay->closed = true;
+}
+
+bool RequestProcessor::WaitForResults(std::unique_lock<std::mutex>& lock, std::chrono::seconds timeout,
+                                      const std::shared_ptr<Relay>& relay, const std::function<bool()>& done) {
+    uint32_t seen = relay ? relay->next_seq.load() : 0;
+    while (!results_cv_.wait_for(lock, timeout, done)) {
+        if (!relay || (relay->next_seq == seen && !relay->sending)) {
+            return false;
+        }
+        seen = relay->next_seq;
+    }
+    return true;
 }
 
 
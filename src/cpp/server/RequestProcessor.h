@@ -6,31 +6,43 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <memory>
 #include <mutex>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <utility>
+#include <functional>
 
 // Forward declarations
 class RequestProcessor {
 public:
+    // Receives result parts as they are produced
+    using ResultSink = std::function<void(mini2::WorkerResult&&)>;
+
     explicit RequestProcessor(const std::string& node_id);
     ~RequestProcessor();
 
     // For Process A (Leader)
-    std::vector<mini2::WorkerResult> ProcessRequest(const mini2::Request& request);
+    // `error` (if given) gets why the result is not the full answer, or ""
+    std::vector<mini2::WorkerResult> ProcessRequest(const mini2::Request& request, std::string* error = nullptr);
+    // Same, handing each part to `sink` as soon as a team leader relays it;
+    // returns the error
+    std::string ProcessRequest(const mini2::Request& request, const ResultSink& sink);
     
     // For Team Leaders (B, E)
     void HandleTeamRequest(const mini2::Request& request);
     
     // For Workers (C, D, F)
     void HandleWorkerRequest(const mini2::Request& request);
-    mini2::WorkerResult GenerateWorkerResult(const mini2::Request& request);
+    // Scan this worker's slice, handing each bounded part to `sink` (the
+    // final one has last=true)
+    void GenerateWorkerResult(const mini2::Request& request, const ResultSink& sink);
     
-    // For Team Leaders - collect worker results
-    void ReceiveWorkerResult(const mini2::WorkerResult& result);
+    // For Team Leaders - collect worker results. Takes the result over, so
+    // the payload is moved (not copied) into storage or on to the relay sink.
+    void ReceiveWorkerResult(mini2::WorkerResult&& result);
 
     // Set neighbor connections from config
     void SetTeamLeaders(const std::vector<std::pair<std::string, std::string>>& team_leader_endpoints);
@@ -40,6 +52,9 @@ public:
     // Real data processing
     void LoadDataset(const std::string& dataset_path);
     bool HasDataset() const;
+    void SetColumnStoreEnabled(bool enabled) { column_store_enabled_ = enabled; }
+    // Threads used to scan a slice (0 = one per core)
+    void SetScanThreads(int threads);
     
     // Status and control
     mini2::StatusResponse GetStatus() const;
@@ -60,11 +75,30 @@ private:
     std::shared_ptr<DataProcessor> data_processor_;
     std::string current_dataset_path_;  // Track currently loaded dataset
     mutable std::mutex dataset_mutex_;
+    bool column_store_enabled_ = false;
+    size_t scan_threads_ = 1;
     
     // Storage for results
     mutable std::mutex results_mutex_;
     std::condition_variable results_cv_;
     std::map<std::string, std::vector<mini2::WorkerResult>> pending_results_;
+
+    // Requests whose results are passed on as they arrive instead of being
+    // collected in pending_results_ (row results at team leaders and A)
+    struct Relay {
+        ResultSink sink;
+        std::mutex send_mutex;  // keeps parts in order, and ahead of the final marker
+        std::atomic<uint32_t> next_seq{0};  // parts passed on so far
+        std::atomic<bool> sending{false};   // a part is in the sink (which may be
+                                            // waiting for the client to read)
+        bool closed = false;    // late parts are dropped (send_mutex)
+        size_t finished = 0;    // sources that sent their last part (results_mutex_)
+        std::string error;      // first one a source flagged (results_mutex_)
+    };
+    std::map<std::string, std::shared_ptr<Relay>> relays_;  // guarded by results_mutex_
+    // Requests without a relay that a thread is waiting to collect from
+    // pending_results_; results for anything else are dropped
+    std::set<std::string> collecting_;  // guarded by results_mutex_
     
     // Status tracking
     std::atomic<bool> shutting_down_;
@@ -72,15 +106,35 @@ private:
     std::atomic<int> requests_processed_;
     
     // Helper methods
-    int ForwardToTeamLeaders(const mini2::Request& req, bool need_green, bool need_pink);
-    int ForwardToWorkers(const mini2::Request& req);
-    mini2::WorkerResult ProcessRealData(std::shared_ptr<DataProcessor> processor, const mini2::Request& req, size_t start_idx, size_t count);
+    int ForwardToTeamLeaders(const mini2::Request& req, bool need_green, bool need_pink, std::string* error);
+    int ForwardToWorkers(const mini2::Request& req, std::string* error);
+    // Send `req` to all `targets` concurrently, retrying a busy peer a few
+    // times; returns how many acked. The first peer that never took it is
+    // described in `error`, as its share of the result is missing.
+    int ForwardToPeers(const mini2::Request& req,
+                       const std::vector<std::pair<std::string, mini2::TeamIngress::Stub*>>& targets,
+                       const std::string& role, const char* peer_label, std::string* error);
+    void PushToLeader(const mini2::WorkerResult& result, const char* role);
+    std::shared_ptr<Relay> OpenRelay(const std::string& request_id, ResultSink sink);
+    // Stop relaying; parts still arriving for the request are dropped
+    void CloseRelay(const std::string& request_id);
+    // Pass one part on as this node's next; caller holds relay.send_mutex
+    void SendRelayed(Relay& relay, mini2::WorkerResult&& result);
+    // Wait on results_cv_ until `done`, giving up after `timeout` without
+    // progress. With a relay, a part passed on, or one still blocked in the
+    // sink, counts as progress: a slow client legitimately holds parts back
+    // through session backpressure.
+    bool WaitForResults(std::unique_lock<std::mutex>& lock, std::chrono::seconds timeout,
+                        const std::shared_ptr<Relay>& relay, const std::function<bool()>& done);
+    void ProcessRealData(std::shared_ptr<DataProcessor> processor, const mini2::Request& req,
+                         size_t start_idx, size_t count, const ResultSink& sink);
     static grpc::ChannelArguments MakeLargeMessageArgs();
     void RegisterPeer(const std::string& addr,
                       std::map<std::string, std::unique_ptr<mini2::TeamIngress::Stub>>& target,
                       const char* label);
     void LoadDatasetIfNeeded(const mini2::Request& request);
-    void ProcessLocally(std::shared_ptr<DataProcessor> processor, const mini2::Request& request, uint32_t partitions);
+    void ProcessLocally(std::shared_ptr<DataProcessor> processor, const mini2::Request& request,
+                        uint32_t partitions, const ResultSink& sink);
     
     std::shared_ptr<DataProcessor> GetDataProcessor() const;
 };
@@ -0,0 +1,189 @@
+#include "RowFilter.h"
+#include "ColumnStore.h"
+#include "CsvScanner.h"
+#include "DataProcessor.h"
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+using Op = FilterPredicate::Op;
+
+const char* OpName(Op op) {
+    switch (op) {
+        case Op::Eq: return "=";
+        case Op::Ne: return "!=";
+        case Op::Lt: return "<";
+        case Op::Le: return "<=";
+        case Op::Gt: return ">";
+        case Op::Ge: return ">=";
+        case Op::Between: return " BETWEEN ";
+        case Op::In: return " IN ";
+    }
+    return "?";
+}
+
+size_t ExpectedValues(Op op, size_t given) {
+    switch (op) {
+        case Op::Between: return 2;
+        case Op::In: return given > 0 ? given : 1;
+        default: return 1;
+    }
+}
+
+template <typename T, typename U>
+bool Compare(Op op, const T& value, const std::vector<U>& literals) {
+    switch (op) {
+        case Op::Eq: return value == literals[0];
+        case Op::Ne: return value != literals[0];
+        case Op::Lt: return value < literals[0];
+        case Op::Le: return value <= literals[0];
+        case Op::Gt: return value > literals[0];
+        case Op::Ge: return value >= literals[0];
+        case Op::Between: return literals[0] <= value && value <= literals[1];
+        case Op::In:
+            for (const auto& literal : literals) {
+                if (value == literal) {
+                    return true;
+                }
+            }
+            return false;
+    }
+    return false;
+}
+
+bool IsNumeric(ColumnType type) {
+    return type == ColumnType::Float64 || type == ColumnType::Int64 ||
+           type == ColumnType::Timestamp || type == ColumnType::Int32;
+}
+
+// A predicate literal for a numeric column; NaN if it isn't one. Unlike row
+// values, a malformed timestamp is an error here rather than 0.
+double ParseLiteral(ColumnType type, std::string_view text) {
+    if (type == ColumnType::Timestamp) {
+        int64_t ts = 0;
+        return ColumnStore::TryParseTimestamp(text, &ts) ? static_cast<double>(ts) : std::nan("");
+    }
+    return csv::ParseDouble(text);
+}
+
+}  // namespace
+
+bool RowFilter::Compile(const std::vector<FilterPredicate>& predicates, const Schema& schema,
+                        const ColumnStore* columns, std::string* error) {
+    terms_.clear();
+    source_ = predicates;
+    match_nothing_ = false;
+
+    for (const auto& pred : predicates) {
+        const ColumnSpec* spec = schema.Find(pred.column);
+        if (!spec) {
+            if (error) *error = "unknown column '" + pred.column + "'";
+            return false;
+        }
+        if (pred.values.size() != ExpectedValues(pred.op, pred.values.size())) {
+            if (error) *error = "wrong number of values for column '" + pred.column + "'";
+            return false;
+        }
+
+        Term term;
+        if (!CompileTerm(pred, *spec, columns, term, error)) {
+            return false;
+        }
+        terms_.push_back(std::move(term));
+    }
+    return true;
+}
+
+bool RowFilter::CompileTerm(const FilterPredicate& pred, const ColumnSpec& spec,
+                            const ColumnStore* columns, Term& term, std::string* error) {
+    term.op = pred.op;
+    term.field = spec.index;
+    term.type = spec.type;
+
+    const Column* column = columns ? columns->Find(spec.index) : nullptr;
+
+    if (column && column->type == ColumnType::Dictionary) {
+        // Evaluate the predicate once per distinct value instead of once per row
+        term.kind = Kind::DictionaryCodes;
+        term.column = column;
+        term.code_matches.resize(column->dictionary.size());
+        bool any = false;
+        for (size_t code = 0; code < column->dictionary.size(); ++code) {
+            bool hit = Compare(pred.op, column->dictionary[code], pred.values);
+            term.code_matches[code] = hit ? 1 : 0;
+            any = any || hit;
+        }
+        if (!any) {
+            match_nothing_ = true;
+        }
+        return true;
+    }
+
+    if (IsNumeric(spec.type)) {
+        for (const auto& value : pred.values) {
+            double number = ParseLiteral(spec.type, value);
+            if (std::isnan(number)) {
+                if (error) *error = "'" + value + "' is not a value of numeric column '" + pred.column + "'";
+                return false;
+            }
+            term.numbers.push_back(number);
+        }
+        term.kind = column ? Kind::StoredNumber : Kind::ParsedNumber;
+        term.column = column;
+        return true;
+    }
+
+    term.kind = Kind::Text;
+    term.texts = pred.values;
+    return true;
+}
+
+bool RowFilter::Matches(const CSVRow& row) const {
+    if (match_nothing_) {
+        return false;
+    }
+    for (const auto& term : terms_) {
+        if (!TermMatches(term, row)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RowFilter::TermMatches(const Term& term, const CSVRow& row) const {
+    switch (term.kind) {
+        case Kind::DictionaryCodes:
+            return term.code_matches[term.column->codes[row.Index()]] != 0;
+
+        case Kind::StoredNumber:
+            return Compare(term.op, term.column->ValueAt(row.Index()), term.numbers);
+
+        case Kind::ParsedNumber: {
+            // Parsed exactly as the column store would have stored it
+            double value = ColumnStore::ParseValue(term.type, csv::FieldAt(row.View(), term.field));
+            return Compare(term.op, value, term.numbers);
+        }
+
+        case Kind::Text: {
+            std::string_view value = csv::FieldAt(row.View(), term.field);
+            return Compare(term.op, value, term.texts);
+        }
+    }
+    return false;
+}
+
+std::string RowFilter::Describe() const {
+    std::ostringstream out;
+    for (size_t i = 0; i < source_.size(); ++i) {
+        const auto& pred = source_[i];
+        if (i > 0) {
+            out << " AND ";
+        }
+        out << pred.column << OpName(pred.op);
+        for (size_t v = 0; v < pred.values.size(); ++v) {
+            out << (v > 0 ? (pred.op == Op::Between ? ".." : "|") : "") << pred.values[v];
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Schema.h"
+
+class CSVRow;
+class ColumnStore;
+struct Column;
+
+// One column predicate, mirroring mini2::Predicate without pulling protobuf
+// into the data layer.
+struct FilterPredicate {
+    enum class Op { Eq, Ne, Lt, Le, Gt, Ge, Between, In };
+
+    std::string column;
+    Op op = Op::Eq;
+    std::vector<std::string> values;  // 1 value; 2 for Between (inclusive); N for In
+};
+
+// Conjunction of predicates compiled against one dataset. Dictionary columns
+// are reduced to a per-code match table, numeric columns compare typed values
+// (from the ColumnStore when materialized, parsed from the row otherwise) and
+// String columns compare text.
+class RowFilter {
+public:
+    // Matches every row
+    RowFilter() = default;
+
+    // Returns false and sets `error` (unknown column, wrong value count, ...)
+    bool Compile(const std::vector<FilterPredicate>& predicates, const Schema& schema,
+                 const ColumnStore* columns, std::string* error);
+
+    bool Empty() const { return terms_.empty() && !match_nothing_; }
+    bool Matches(const CSVRow& row) const;
+
+    std::string Describe() const;
+
+private:
+    enum class Kind { DictionaryCodes, StoredNumber, ParsedNumber, Text };
+
+    struct Term {
+        Kind kind = Kind::Text;
+        FilterPredicate::Op op = FilterPredicate::Op::Eq;
+        size_t field = 0;
+        ColumnType type = ColumnType::String;
+        const Column* column = nullptr;     // StoredNumber / DictionaryCodes
+        std::vector<char> code_matches;     // DictionaryCodes: code -> match
+        std::vector<double> numbers;        // StoredNumber / ParsedNumber literals
+        std::vector<std::string> texts;     // Text literals
+    };
+
+    bool CompileTerm(const FilterPredicate& pred, const ColumnSpec& spec,
+                     const ColumnStore* columns, Term& term, std::string* error);
+    bool TermMatches(const Term& term, const CSVRow& row) const;
+
+    std::vector<Term> terms_;
+    std::vector<FilterPredicate> source_;
+    bool match_nothing_ = false;  // e.g. equality on a value absent from a dictionary
+};
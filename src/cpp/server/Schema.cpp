@@ -0,0 +1,57 @@
+#include "Schema.h"
+#include "CsvScanner.h"
+
+const char* ColumnTypeName(ColumnType type) {
+    switch (type) {
+        case ColumnType::Float64: return "float64";
+        case ColumnType::Int64: return "int64";
+        case ColumnType::Timestamp: return "timestamp";
+        case ColumnType::Int32: return "int32";
+        case ColumnType::Dictionary: return "dictionary";
+        case ColumnType::String: return "string";
+    }
+    return "unknown";
+}
+
+Schema::Schema(const std::string& header, char delimiter) {
+    std::vector<std::string_view> names;
+    csv::SplitFields(header, delimiter, names);
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        ColumnSpec spec;
+        spec.name = std::string(names[i]);
+        spec.index = i;
+        spec.type = TypeForColumn(spec.name);
+        by_name_.emplace(spec.name, i);  // First occurrence wins on duplicates
+        columns_.push_back(std::move(spec));
+    }
+}
+
+const ColumnSpec* Schema::Find(const std::string& name) const {
+    auto it = by_name_.find(name);
+    return (it == by_name_.end()) ? nullptr : &columns_[it->second];
+}
+
+int Schema::IndexOf(const std::string& name) const {
+    auto it = by_name_.find(name);
+    return (it == by_name_.end()) ? -1 : static_cast<int>(it->second);
+}
+
+ColumnType Schema::TypeForColumn(const std::string& name) {
+    static const std::unordered_map<std::string, ColumnType> kAirQuality = {
+        {"Latitude", ColumnType::Float64},
+        {"Longitude", ColumnType::Float64},
+        {"UTC", ColumnType::Timestamp},
+        {"Parameter", ColumnType::Dictionary},
+        {"Concentration", ColumnType::Int32},
+        {"Unit", ColumnType::Dictionary},
+        {"Raw Concentration", ColumnType::Int32},
+        {"AQI", ColumnType::Int32},
+        {"Category", ColumnType::Int32},
+        {"Site Name", ColumnType::Dictionary},
+        {"Site Agency", ColumnType::Dictionary},
+        {"AQS ID", ColumnType::Int64},
+    };
+    auto it = kAirQuality.find(name);
+    return (it == kAirQuality.end()) ? ColumnType::String : it->second;
+}
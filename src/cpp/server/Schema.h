@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ColumnType {
+    Float64,     // latitude / longitude
+    Int64,       // AQS ID
+    Timestamp,   // UTC, stored as int64 unix seconds
+    Int32,       // concentration, AQI, category
+    Dictionary,  // low-cardinality text (parameter, unit, site, agency)
+    String       // anything else, kept as views into the dataset
+};
+
+const char* ColumnTypeName(ColumnType type);
+
+struct ColumnSpec {
+    std::string name;
+    size_t index = 0;  // field position in a row
+    ColumnType type = ColumnType::String;
+};
+
+// Header compiled once per dataset: column name -> field index and type.
+// Types follow the air-quality schema written by test_data/gen_test_data.py;
+// columns it does not know about are String.
+class Schema {
+public:
+    Schema() = default;
+    explicit Schema(const std::string& header, char delimiter = ',');
+
+    size_t NumColumns() const { return columns_.size(); }
+    const ColumnSpec& At(size_t index) const { return columns_[index]; }
+
+    // nullptr / -1 if the header has no such column
+    const ColumnSpec* Find(const std::string& name) const;
+    int IndexOf(const std::string& name) const;
+
+    static ColumnType TypeForColumn(const std::string& name);
+
+private:
+    std::vector<ColumnSpec> columns_;
+    std::unordered_map<std::string, size_t> by_name_;
+};
@@ -4,6 +4,7 @@
 #include "../common/config.h"
 #include "RequestProcessor.h"
 #include "SessionManager.h"
+#include "WorkerQueue.h"
 #include <iostream>
 #include <memory>
 #include <csignal>
@@ -25,6 +26,15 @@ int main(int argc, char** argv){
     
     std::string config_path = "config/network_setup.json";
     std::string node_id = "A";
+    bool column_store = false;
+    int ingress_threads = 4;     // concurrent HandleRequest jobs
+    size_t ingress_queue = 64;   // accepted but not yet started
+    int scan_threads = 0;        // per-request scan parallelism (0 = all cores)
+    size_t session_budget_mb = 256;   // unconsumed chunk bytes per session
+    size_t memory_budget_mb = 1024;   // ... and across all sessions
+    size_t spill_watermark_mb = 0;    // spill new chunks to disk above this (0 = never)
+    std::string spill_dir = "/tmp";
+    uint32_t read_ahead_chunks = 4;   // spilled chunks to pull back ahead of in-order readers
     
     if (argc > 1 && argv[1][0] != '-') {
         node_id = argv[1];
@@ -33,6 +43,15 @@ int main(int argc, char** argv){
             std::string a = argv[i];
             if (a=="--config" && i+1<argc) config_path = argv[++i];
             else if (a=="--node" && i+1<argc) node_id = argv[++i];
+            else if (a=="--columnar") column_store = true;
+            else if (a=="--threads" && i+1<argc) ingress_threads = std::stoi(argv[++i]);
+            else if (a=="--queue-size" && i+1<argc) ingress_queue = std::stoul(argv[++i]);
+            else if (a=="--scan-threads" && i+1<argc) scan_threads = std::stoi(argv[++i]);
+            else if (a=="--session-budget-mb" && i+1<argc) session_budget_mb = std::stoul(argv[++i]);
+            else if (a=="--memory-budget-mb" && i+1<argc) memory_budget_mb = std::stoul(argv[++i]);
+            else if (a=="--spill-watermark-mb" && i+1<argc) spill_watermark_mb = std::stoul(argv[++i]);
+            else if (a=="--spill-dir" && i+1<argc) spill_dir = argv[++i];
+            else if (a=="--read-ahead" && i+1<argc) read_ahead_chunks = static_cast<uint32_t>(std::stoul(argv[++i]));
         }
     }
     
@@ -69,7 +88,12 @@ int main(int argc, char** argv){
     std::string public_addr = me.host + ":" + std::to_string(me.port);
 
     auto processor = std::make_shared<RequestProcessor>(node_id);
+    processor->SetColumnStoreEnabled(column_store);
+    processor->SetScanThreads(scan_threads);
     auto session_manager = std::make_shared<SessionManager>();    
+    session_manager->SetBudgets(session_budget_mb << 20, memory_budget_mb << 20);
+    session_manager->SetSpill(spill_dir, spill_watermark_mb << 20);
+    session_manager->SetReadAhead(read_ahead_chunks);
     if (node_id == "A") {
         std::string addr_B = cfg.nodes["B"].host + ":" + std::to_string(cfg.nodes["B"].port);
         std::string addr_E = cfg.nodes["E"].host + ":" + std::to_string(cfg.nodes["E"].port);
@@ -117,8 +141,11 @@ int main(int argc, char** argv){
     b.SetMaxReceiveMessageSize(1536 * 1024 * 1024); // 1.5GB
     b.SetMaxSendMessageSize(1536 * 1024 * 1024);    // 1.5GB
     
+    auto work_queue = std::make_shared<WorkerQueue>(node_id, ingress_threads, ingress_queue);
+    work_queue->Start();
+
     NodeControlService nodeSvc(processor, node_id);
-    TeamIngressService teamSvc(processor, node_id);
+    TeamIngressService teamSvc(processor, work_queue, node_id);
     ClientGatewayService clientSvc(processor, session_manager);
 
     b.AddListeningPort(bind_addr, grpc::InsecureServerCredentials());
@@ -163,6 +190,7 @@ int main(int argc, char** argv){
     
     auto deadline = std::chrono::system_clock::now() + std::chrono::seconds(5);
     server->Shutdown(deadline);
+    work_queue->Stop();
     
     std::cout << "[Server:" << node_id << "] Shutdown complete" << std::endl;
     
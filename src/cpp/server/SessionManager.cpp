@@ -3,17 +3,33 @@
 #include <sstream>
 #include <iomanip>
 #include <random>
+#include <algorithm>
 
-SessionManager::SessionManager() {
-    std::cout << "[SessionManager] init" << std::endl;
+SessionManager::SessionManager(size_t shards)
+    : shards_(std::max<size_t>(1, shards)) {
+    std::cout << "[SessionManager] init (" << shards_.size() << " shards)" << std::endl;
     StartCleanupThread();
+    read_ahead_running_ = true;
+    read_ahead_thread_ = std::thread(&SessionManager::ReadAheadThreadFunc, this);
 }
 
 SessionManager::~SessionManager() {
+    {
+        std::lock_guard<std::mutex> lock(read_ahead_mutex_);
+        read_ahead_running_ = false;
+    }
+    read_ahead_cv_.notify_all();
+    if (read_ahead_thread_.joinable()) {
+        read_ahead_thread_.join();
+    }
     StopCleanupThread();
     std::cout << "[SessionManager] destroy" << std::endl;
 }
 
+SessionManager::Shard& SessionManager::ShardFor(const std::string& session_id) {
+    return shards_[std::hash<std::string>{}(session_id) % shards_.size()];
+}
+
 std::string SessionManager::GenerateSessionId() {
     // Generate unique session ID using timestamp + random
     auto now = std::chrono::system_clock::now();
@@ -29,18 +45,42 @@ std::string SessionManager::GenerateSessionId() {
     return ss.str();
 }
 
+void SessionManager::SetBudgets(size_t session_bytes, size_t total_bytes) {
+    session_budget_bytes_ = session_bytes;
+    total_budget_bytes_ = total_bytes;
+    std::cout << "[SessionManager] budgets: session=" << (session_bytes >> 20) 
+              << "MB total=" << (total_bytes >> 20) << "MB" << std::endl;
+}
+
+void SessionManager::SetSpill(const std::string& dir, size_t watermark_bytes) {
+    spill_dir_ = dir;
+    spill_watermark_bytes_ = watermark_bytes;
+    if (watermark_bytes > 0) {
+        std::cout << "[SessionManager] spill to " << dir << " above " 
+                  << (watermark_bytes >> 20) << "MB" << std::endl;
+    }
+}
+
+void SessionManager::SetReadAhead(uint32_t chunks) {
+    read_ahead_chunks_ = chunks;
+    std::cout << "[SessionManager] read-ahead: " << chunks << " chunk(s)" << std::endl;
+}
+
 std::string SessionManager::CreateSession(const mini2::Request& req) {
-    std::string session_id = GenerateSessionId();
-    
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
-    // Use emplace to construct in place (avoids copy/move of mutex)
-    auto& session = sessions_[session_id];
-    session.request_id = session_id;
-    session.created_at = std::chrono::steady_clock::now();
-    session.last_access = std::chrono::steady_clock::now();
-    session.complete = false;
-    session.next_poll_index = 0;
+    auto session = std::make_shared<Session>();
+    session->created_at = std::chrono::steady_clock::now();
+    session->last_access = std::chrono::steady_clock::now();
+    
+    // Ids only have a 4-digit random part per millisecond, so under a burst
+    // of clients draw again rather than overwrite a live session
+    std::string session_id;
+    for (bool inserted = false; !inserted; ) {
+        session_id = GenerateSessionId();
+        Shard& shard = ShardFor(session_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        inserted = shard.sessions.emplace(session_id, session).second;
+    }
+    session->request_id = session_id;
     
     std::cout << "[SessionManager] new session " << session_id 
               << " query=" << req.query() << std::endl;
@@ -48,109 +88,407 @@ std::string SessionManager::CreateSession(const mini2::Request& req) {
     return session_id;
 }
 
-void SessionManager::AddChunk(const std::string& session_id, const mini2::WorkerResult& result) {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
-    auto it = sessions_.find(session_id);
-    if (it == sessions_.end()) {
-        std::cerr << "[SessionManager] Session not found: " << session_id << std::endl;
+bool SessionManager::HasSession(const std::string& session_id) {
+    return FindSession(session_id, false) != nullptr;
+}
+
+std::shared_ptr<SessionManager::Session> SessionManager::FindSession(const std::string& session_id, bool touch) {
+    Shard& shard = ShardFor(session_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(session_id);
+    if (it == shard.sessions.end()) {
+        return nullptr;
+    }
+    if (touch) {
+        it->second->last_access = std::chrono::steady_clock::now();  // Update access time
+    }
+    return it->second;
+}
+
+bool SessionManager::ReserveBuffered(size_t bytes, size_t limit) {
+    size_t total = total_buffered_bytes_.load();
+    do {
+        if (total + bytes > limit) {
+            return false;
+        }
+    } while (!total_buffered_bytes_.compare_exchange_weak(total, total + bytes));
+    return true;
+}
+
+void SessionManager::Unbuffer(Session& session, size_t bytes) {
+    session.buffered_bytes -= bytes;
+    total_buffered_bytes_ -= bytes;
+}
+
+void SessionManager::ReleaseChunks(Session& session, uint32_t upto) {
+    upto = std::min<uint32_t>(upto, static_cast<uint32_t>(session.chunks.size()));
+    if (upto <= session.released) {
         return;
     }
+    for (uint32_t i = session.released; i < upto; ++i) {
+        Chunk& chunk = session.chunks[i];
+        if (chunk.spilled) {
+            session.spill->Discard(chunk.spill_offset, chunk.spill_length);
+            session.spilled_bytes -= chunk.spill_length;
+            total_spilled_bytes_ -= chunk.spill_length;
+            chunk.spill_length = 0;
+        }
+        // In memory, or a spilled chunk that was read ahead
+        Unbuffer(session, chunk.payload.size());
+        std::string().swap(chunk.payload);
+    }
+    session.released = upto;
     
-    Session& session = it->second;
+    // Producers may be waiting for room
+    session.cv.notify_all();
+}
+
+void SessionManager::CloseSession(Session& session) {
     std::lock_guard<std::mutex> session_lock(session.mutex);
+    session.closed = true;
+    Unbuffer(session, session.buffered_bytes);
+    total_spilled_bytes_ -= session.spilled_bytes;  // segment goes with the session
+    session.spilled_bytes = 0;
+    session.cv.notify_all();
+}
+
+bool SessionManager::SpillChunk(Session& session, std::string& payload, Chunk* chunk) {
+    std::string error;
+    if (!session.spill) {
+        session.spill = SpillSegment::Create(spill_dir_, &error);
+        if (!session.spill) {
+            std::cerr << "[SessionManager] can't spill " << session.request_id << ": " << error << std::endl;
+            return false;
+        }
+        std::cout << "[SessionManager] " << session.request_id << " spilling to disk (memory total=" 
+                  << total_buffered_bytes_ << ")" << std::endl;
+    }
+    uint64_t offset = 0;
+    if (!session.spill->Append(payload, &offset)) {
+        std::cerr << "[SessionManager] spill write failed for " << session.request_id << std::endl;
+        return false;
+    }
+    chunk->spilled = true;
+    chunk->spill_offset = offset;
+    chunk->spill_length = payload.size();
+    session.spilled_bytes += payload.size();
+    total_spilled_bytes_ += payload.size();
+    std::string().swap(payload);
+    return true;
+}
+
+bool SessionManager::ReadChunk(Session& session, uint32_t index, std::string* out) {
+    const Chunk& chunk = session.chunks[index];
+    if (!chunk.spilled || !chunk.payload.empty()) {
+        *out = chunk.payload;
+        return true;
+    }
+    if (!session.spill->Read(chunk.spill_offset, chunk.spill_length, out)) {
+        std::cerr << "[SessionManager] spill read failed for chunk " << index 
+                  << " of " << session.request_id << std::endl;
+        return false;
+    }
+
+    // Clients read in order: start pulling the next --read-ahead spilled
+    // chunks in while this one is on the wire
+    if (read_ahead_chunks_ == 0) {
+        return true;
+    }
+    uint64_t ahead_begin = 0, ahead_end = 0;
+    for (uint32_t i = index + 1; i < session.chunks.size() && i - index <= read_ahead_chunks_; ++i) {
+        const Chunk& next = session.chunks[i];
+        if (!next.spilled) {
+            continue;
+        }
+        if (ahead_end == 0) {
+            ahead_begin = next.spill_offset;
+        }
+        ahead_end = next.spill_offset + next.spill_length;
+    }
+    if (ahead_end > ahead_begin) {
+        session.spill->WillNeed(ahead_begin, static_cast<size_t>(ahead_end - ahead_begin));
+    }
+    return true;
+}
+
+bool SessionManager::AddChunk(const std::string& session_id, mini2::WorkerResult&& result) {
+    auto session = FindSession(session_id, false);
+    if (!session) {
+        std::cerr << "[SessionManager] Session not found: " << session_id << std::endl;
+        return false;
+    }
     
-    session.chunks.push_back(result);
+    const uint32_t part_index = result.part_index();
+    std::string payload = std::move(*result.mutable_payload());
+    const size_t bytes = payload.size();
+    std::unique_lock<std::mutex> session_lock(session->mutex);
+    
+    // Past the watermark new chunks go to disk; they cost no memory, so
+    // they don't wait on the budgets either
+    Chunk chunk;
+    if (spill_watermark_bytes_ > 0 && bytes > 0 && !session->closed &&
+        total_buffered_bytes_ + bytes > spill_watermark_bytes_) {
+        SpillChunk(*session, payload, &chunk);
+    }
     
-    std::cout << "[SessionManager] add chunk " << result.part_index() 
+    // Wait for the client to catch up. A session holding nothing may always
+    // add a chunk, so an oversized chunk can't wedge it and every session
+    // keeps moving under the node-wide limit. Producers of other sessions
+    // race for the node-wide room, so it is claimed in the same step as the
+    // check.
+    auto reserve = [&]() {
+        if (session->buffered_bytes == 0) {
+            total_buffered_bytes_ += bytes;
+            return true;
+        }
+        return session->buffered_bytes + bytes <= session_budget_bytes_ &&
+               ReserveBuffered(bytes, total_budget_bytes_);
+    };
+    bool reserved = false;
+    if (!chunk.spilled && !session->closed && !(reserved = reserve())) {
+        std::cout << "[SessionManager] " << session_id << " over budget (session=" 
+                  << session->buffered_bytes << " total=" << total_buffered_bytes_ 
+                  << "), producer waiting" << std::endl;
+        auto wait_start = std::chrono::steady_clock::now();
+        while (!session->closed && !(reserved = reserve())) {
+            // Releases in this session notify cv; room freed by other sessions
+            // only shows up in the total, so re-check that periodically
+            session->cv.wait_for(session_lock, std::chrono::milliseconds(100));
+        }
+        std::cout << "[SessionManager] " << session_id << " producer resumed after " 
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - wait_start).count() 
+                  << " ms" << std::endl;
+    }
+    if (session->closed) {
+        std::cerr << "[SessionManager] " << session_id << " closed, dropping chunk" << std::endl;
+        return false;
+    }
+    
+    if (!chunk.spilled) {
+        chunk.payload = std::move(payload);
+        session->buffered_bytes += bytes;  // the total was reserved above
+    }
+    session->chunks.push_back(std::move(chunk));
+    
+    std::cout << "[SessionManager] add chunk " << part_index 
               << " -> " << session_id 
-              << " total=" << session.chunks.size() << std::endl;
+              << " total=" << session->chunks.size() 
+              << " buffered=" << session->buffered_bytes 
+              << " spilled=" << session->spilled_bytes << std::endl;
     
     // Notify waiting threads (for GetNext)
-    session.cv.notify_all();
+    session->cv.notify_all();
+    return true;
 }
 
 bool SessionManager::GetNextChunk(const std::string& session_id, uint32_t index, 
-                                   mini2::NextChunkResp* resp) {
-    std::unique_lock<std::mutex> lock(sessions_mutex_);
-    
-    auto it = sessions_.find(session_id);
-    if (it == sessions_.end()) {
+                                   mini2::NextChunkResp* resp, uint32_t window,
+                                   const std::function<bool()>& cancelled) {
+    auto session = FindSession(session_id, true);
+    if (!session) {
         std::cerr << "[SessionManager] GetNext: Session not found: " << session_id << std::endl;
         return false;
     }
     
-    Session& session = it->second;
-    session.last_access = std::chrono::steady_clock::now();  // Update access time
-    lock.unlock();  // Release sessions_ lock
+    std::unique_lock<std::mutex> session_lock(session->mutex);
     
-    std::unique_lock<std::mutex> session_lock(session.mutex);
+    // The client has everything before `index`, less the requests it still
+    // has in flight ahead of this one (they may arrive out of order)
+    window = std::max<uint32_t>(1, window);
+    ReleaseChunks(*session, index + 1 > window ? index + 1 - window : 0);
+    if (index < session->released) {
+        std::cerr << "[SessionManager] chunk " << index << " of " << session_id 
+                  << " was already released" << std::endl;
+        return false;
+    }
     
-        // Wait until chunk is available or session is complete
-    while (index >= session.chunks.size() && !session.complete) {
+    // Wait until chunk is available or session is complete, at most 310
+    // seconds (longer than the team leader timeout of 300s). A caller that
+    // can be cancelled is re-checked every 100ms.
+    auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(310);
+    if (index >= session->chunks.size() && !session->complete && !session->closed) {
         std::cout << "[SessionManager] wait chunk " << index 
               << " in " << session_id << std::endl;
-        
-        // Wait with timeout (310 seconds - longer than team leader timeout of 300s)
-        if (session.cv.wait_for(session_lock, std::chrono::seconds(310)) == std::cv_status::timeout) {
+    }
+    while (index >= session->chunks.size() && !session->complete && !session->closed) {
+        if (cancelled && cancelled()) {
+            std::cerr << "[SessionManager] GetNext for chunk " << index << " of " << session_id 
+                      << " cancelled" << std::endl;
+            return false;
+        }
+        auto wake = cancelled ? std::min(give_up, std::chrono::steady_clock::now() + std::chrono::milliseconds(100))
+                              : give_up;
+        if (session->cv.wait_until(session_lock, wake) == std::cv_status::timeout &&
+            std::chrono::steady_clock::now() >= give_up) {
             std::cerr << "[SessionManager] timeout waiting for chunk " << index << std::endl;
             return false;
         }
-    }    // Check if chunk is available
-    if (index < session.chunks.size()) {
-        const auto& chunk = session.chunks[index];
+    }
+    
+    // Check if chunk is available
+    if (index < session->chunks.size()) {
+        std::string payload;
+        if (!ReadChunk(*session, index, &payload)) {
+            return false;
+        }
         resp->set_request_id(session_id);
-        resp->set_chunk(chunk.payload());
+        resp->set_chunk(std::move(payload));
         
         // Check if more chunks are coming
-        bool has_more = (index + 1 < session.chunks.size()) || !session.complete;
+        bool has_more = (index + 1 < session->chunks.size()) || !session->complete;
         resp->set_has_more(has_more);
+        if (!has_more) {
+            resp->set_error(session->error);
+        }
         
         std::cout << "[SessionManager] got chunk " << index 
               << " has_more=" << has_more << std::endl;
         
+        TrackAccess(session, index, window);
         return true;
     }
     
     // Session complete but no chunk at this index
     resp->set_request_id(session_id);
     resp->set_has_more(false);
+    resp->set_error(session->error);
     
     std::cout << "[SessionManager] complete, no more chunks" << std::endl;
     return false;
 }
 
+void SessionManager::TrackAccess(const std::shared_ptr<Session>& session, uint32_t index, uint32_t window) {
+    // A prefetching client has up to `window` calls in flight, so they may
+    // land a little out of order and still be a sequential read
+    if (index >= session->next_expected && index - session->next_expected < window) {
+        session->sequential_run++;
+    } else {
+        session->sequential_run = 0;
+    }
+    session->next_expected = std::max(session->next_expected, index + 1);
+
+    // Chunks still in memory are already as close as they get
+    constexpr uint32_t kSequentialRun = 2;
+    if (read_ahead_chunks_ == 0 || !session->spill || session->sequential_run < kSequentialRun) {
+        return;
+    }
+    const uint32_t upto = session->next_expected + read_ahead_chunks_;
+    if (upto <= session->read_ahead_upto) {
+        return;
+    }
+    session->read_ahead_upto = upto;
+    if (session->read_ahead_queued) {
+        return;
+    }
+    session->read_ahead_queued = true;
+    {
+        std::lock_guard<std::mutex> lock(read_ahead_mutex_);
+        read_ahead_queue_.push_back(session);
+    }
+    read_ahead_cv_.notify_one();
+}
+
+void SessionManager::ReadAhead(Session& session) {
+    session.read_ahead_queued = false;
+    if (session.closed || !session.spill) {
+        return;
+    }
+    const uint32_t end = std::min<uint32_t>(session.read_ahead_upto, 
+                                            static_cast<uint32_t>(session.chunks.size()));
+    uint32_t loaded = 0;
+    size_t loaded_bytes = 0;
+    for (uint32_t i = std::max(session.released, session.next_expected); i < end; ++i) {
+        Chunk& chunk = session.chunks[i];
+        if (!chunk.spilled || !chunk.payload.empty()) {
+            continue;
+        }
+        // Only use memory the producers could have used without spilling
+        const size_t bytes = chunk.spill_length;
+        if (session.buffered_bytes + bytes > session_budget_bytes_ ||
+            !ReserveBuffered(bytes, std::min(total_budget_bytes_, spill_watermark_bytes_))) {
+            break;
+        }
+        if (!session.spill->Read(chunk.spill_offset, bytes, &chunk.payload)) {
+            std::cerr << "[SessionManager] read-ahead failed for chunk " << i 
+                      << " of " << session.request_id << std::endl;
+            std::string().swap(chunk.payload);
+            total_buffered_bytes_ -= bytes;
+            break;
+        }
+        session.buffered_bytes += bytes;
+        loaded++;
+        loaded_bytes += bytes;
+    }
+    if (loaded > 0) {
+        std::cout << "[SessionManager] read ahead " << loaded << " chunk(s), " << loaded_bytes 
+                  << " bytes of " << session.request_id << std::endl;
+    }
+}
+
+void SessionManager::ReadAheadThreadFunc() {
+    std::unique_lock<std::mutex> lock(read_ahead_mutex_);
+    while (true) {
+        read_ahead_cv_.wait(lock, [this] { return !read_ahead_running_ || !read_ahead_queue_.empty(); });
+        if (!read_ahead_running_) {
+            break;
+        }
+        std::shared_ptr<Session> session = read_ahead_queue_.front().lock();
+        read_ahead_queue_.pop_front();
+        if (!session) {
+            continue;  // erased since it was queued
+        }
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> session_lock(session->mutex);
+            ReadAhead(*session);
+        }
+        lock.lock();
+    }
+}
+
 bool SessionManager::PollNextChunk(const std::string& session_id, mini2::PollResp* resp) {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
-    auto it = sessions_.find(session_id);
-    if (it == sessions_.end()) {
+    auto session = FindSession(session_id, true);
+    if (!session) {
         std::cerr << "[SessionManager] PollNext: Session not found: " << session_id << std::endl;
         return false;
     }
     
-    Session& session = it->second;
-    session.last_access = std::chrono::steady_clock::now();  // Update access time
-    std::lock_guard<std::mutex> session_lock(session.mutex);
+    std::lock_guard<std::mutex> session_lock(session->mutex);
     
     resp->set_request_id(session_id);
     
     // Check if next chunk is available
-    if (session.next_poll_index < session.chunks.size()) {
-        const auto& chunk = session.chunks[session.next_poll_index];
+    if (session->next_poll_index < session->chunks.size()) {
+        const uint32_t index = session->next_poll_index;
         
+        // Polling hands each chunk out once: an in-memory payload moves into
+        // the response instead of being copied, and either kind is released
+        std::string payload;
+        if (session->chunks[index].spilled && session->chunks[index].payload.empty()) {
+            if (!ReadChunk(*session, index, &payload)) {
+                return false;
+            }
+        } else {
+            payload.swap(session->chunks[index].payload);
+            Unbuffer(*session, payload.size());
+        }
         resp->set_ready(true);
-        resp->set_chunk(chunk.payload());
+        resp->set_chunk(std::move(payload));
         
         // Increment for next poll
-        session.next_poll_index++;
+        session->next_poll_index++;
+        ReleaseChunks(*session, session->next_poll_index);
         
         // Check if more chunks are coming
-        bool has_more = (session.next_poll_index < session.chunks.size()) || !session.complete;
+        bool has_more = (session->next_poll_index < session->chunks.size()) || !session->complete;
         resp->set_has_more(has_more);
+        if (!has_more) {
+            resp->set_error(session->error);
+        }
         
         std::cout << "[SessionManager] poll -> chunk " 
-              << (session.next_poll_index - 1) 
+              << (session->next_poll_index - 1) 
               << " ready=1 has_more=" << has_more << std::endl;
         
         return true;
@@ -158,65 +496,79 @@ bool SessionManager::PollNextChunk(const std::string& session_id, mini2::PollRes
     
     // Chunk not ready yet
     resp->set_ready(false);
-    resp->set_has_more(!session.complete);
+    resp->set_has_more(!session->complete);
+    if (session->complete) {
+        resp->set_error(session->error);
+    }
     
     std::cout << "[SessionManager] poll: not ready (complete=" 
-              << session.complete << ")" << std::endl;
+              << session->complete << ")" << std::endl;
     
     return true;
 }
 
-void SessionManager::CompleteSession(const std::string& session_id) {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
-    auto it = sessions_.find(session_id);
-    if (it == sessions_.end()) {
+void SessionManager::CompleteSession(const std::string& session_id, const std::string& error) {
+    auto session = FindSession(session_id, false);
+    if (!session) {
         std::cerr << "[SessionManager] CompleteSession: Session not found: " << session_id << std::endl;
         return;
     }
     
-    Session& session = it->second;
-    std::lock_guard<std::mutex> session_lock(session.mutex);
+    std::lock_guard<std::mutex> session_lock(session->mutex);
     
-    session.complete = true;
+    session->complete = true;
+    session->error = error;
     
     std::cout << "[SessionManager] done session " << session_id 
-              << " chunks=" << session.chunks.size() << std::endl;
+              << " chunks=" << session->chunks.size() 
+              << (error.empty() ? "" : " error=" + error) << std::endl;
     
     // Notify all waiting threads
-    session.cv.notify_all();
+    session->cv.notify_all();
 }
 
 void SessionManager::CleanupSession(const std::string& session_id) {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
-    auto it = sessions_.find(session_id);
-    if (it != sessions_.end()) {
-        sessions_.erase(it);
-        std::cout << "[SessionManager] erase session " << session_id << std::endl;
+    Shard& shard = ShardFor(session_id);
+    std::shared_ptr<Session> session;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(session_id);
+        if (it == shard.sessions.end()) {
+            return;
+        }
+        session = std::move(it->second);
+        shard.sessions.erase(it);
     }
+    
+    // Our reference keeps it alive for whoever is still blocked on it
+    CloseSession(*session);
+    std::cout << "[SessionManager] erase session " << session_id << std::endl;
 }
 
 void SessionManager::CleanupOldSessions(std::chrono::seconds max_age) {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
     auto now = std::chrono::steady_clock::now();
-    int cleaned = 0;
-    
-    for (auto it = sessions_.begin(); it != sessions_.end(); ) {
-        auto age = std::chrono::duration_cast<std::chrono::seconds>(
-            now - it->second.created_at);
-        
-        if (age > max_age && it->second.complete) {
-            it = sessions_.erase(it);
-            cleaned++;
-        } else {
-            ++it;
+    std::vector<std::shared_ptr<Session>> erased;
+    
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end(); ) {
+            auto age = std::chrono::duration_cast<std::chrono::seconds>(
+                now - it->second->created_at);
+            
+            if (age > max_age && it->second->complete) {
+                erased.push_back(std::move(it->second));
+                it = shard.sessions.erase(it);
+            } else {
+                ++it;
+            }
         }
     }
+    for (const auto& session : erased) {
+        CloseSession(*session);
+    }
     
-    if (cleaned > 0) {
-        std::cout << "[SessionManager] cleaned " << cleaned << " old session(s)" << std::endl;
+    if (!erased.empty()) {
+        std::cout << "[SessionManager] cleaned " << erased.size() << " old session(s)" << std::endl;
     }
 }
 
@@ -250,26 +602,31 @@ void SessionManager::CleanupThreadFunc() {
 
 void SessionManager::CleanupStaleSessions() {
     auto now = std::chrono::steady_clock::now();
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    
     std::vector<std::string> to_remove;
-    
-    // Find stale sessions
-    for (auto& pair : sessions_) {
-        auto& session = pair.second;
-        
-        // Check if session is stale (no access for timeout duration)
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-            now - session.last_access);
-        
-        if (elapsed > session_timeout_) {
-            to_remove.push_back(pair.first);
+    std::vector<std::shared_ptr<Session>> erased;
+    
+    // One shard at a time, so clients of the other shards carry on
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end(); ) {
+            // Check if session is stale (no access for timeout duration)
+            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                now - it->second->last_access);
+            
+            if (elapsed > session_timeout_) {
+                to_remove.push_back(it->first);
+                erased.push_back(std::move(it->second));
+                it = shard.sessions.erase(it);
+            } else {
+                ++it;
+            }
         }
     }
+    for (const auto& session : erased) {
+        CloseSession(*session);
+    }
     
-    // Remove stale sessions
     for (const auto& session_id : to_remove) {
-        sessions_.erase(session_id);
         std::cout << "[SessionManager] stale session " << session_id 
               << " (>" << session_timeout_.count() << "s)" << std::endl;
     }
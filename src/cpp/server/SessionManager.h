@@ -1,34 +1,77 @@
 #pragma once
 
 #include "minitwo.grpc.pb.h"
+#include "SpillSegment.h"
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <thread>
+#include <deque>
+#include <functional>
 
 class SessionManager {
 public:
-    SessionManager();
+    // The session table is split into `shards` independently locked parts,
+    // picked by session-id hash, so calls on different sessions rarely
+    // contend
+    explicit SessionManager(size_t shards = kDefaultShards);
     ~SessionManager();
+
+    static constexpr size_t kDefaultShards = 64;
     
     // Create new session for a request
     std::string CreateSession(const mini2::Request& req);
     
-    // Add chunk to session (called as results arrive from workers)
-    void AddChunk(const std::string& session_id, const mini2::WorkerResult& result);
+    // Unconsumed payload bytes allowed per session and across all sessions.
+    // A producer that would go over waits for the client to catch up.
+    void SetBudgets(size_t session_bytes, size_t total_bytes);
+
+    // Unconsumed payload bytes held in memory / spilled, across all sessions
+    size_t GetBufferedBytes() const { return total_buffered_bytes_; }
+    size_t GetSpilledBytes() const { return total_spilled_bytes_; }
+
+    // Once the node holds more than `watermark_bytes` of unread chunks, new
+    // ones go to a per-session segment file under `dir` instead of RAM (and
+    // are read back from it transparently). 0 turns spilling off.
+    void SetSpill(const std::string& dir, size_t watermark_bytes);
+
+    // Once a client has read a session's chunks in order a couple of times,
+    // the next `chunks` spilled ones are read back into memory in the
+    // background, as far as the budgets and the spill watermark allow, before
+    // it asks for them; the same number sizes the kernel prefetch hint given
+    // on every spilled read. 0 turns both off.
+    void SetReadAhead(uint32_t chunks);
+
+    // Add chunk to session (called as results arrive from workers); the
+    // result is moved in, payload included. Blocks while the session or the
+    // node is over budget; false if the session went away or the client
+    // stopped reading (the chunk is dropped).
+    bool AddChunk(const std::string& session_id, mini2::WorkerResult&& result);
     
-    // Get next chunk by index (blocking - waits if chunk not ready yet)
+    // Get next chunk by index (blocking - waits if chunk not ready yet).
+    // A client with `window` requests in flight has received everything
+    // before `index - window + 1`, so those chunks are released; with the
+    // default of one (or 0) that is everything before `index`. While waiting,
+    // `cancelled` (if set) is polled and gives up the wait once it is true.
     bool GetNextChunk(const std::string& session_id, uint32_t index, 
-                      mini2::NextChunkResp* resp);
+                      mini2::NextChunkResp* resp, uint32_t window = 1,
+                      const std::function<bool()>& cancelled = nullptr);
+
+    // False once the session has been closed or timed out
+    bool HasSession(const std::string& session_id);
     
     // Poll for next available chunk (non-blocking)
     bool PollNextChunk(const std::string& session_id, mini2::PollResp* resp);
     
-    // Mark session as complete (no more chunks coming)
-    void CompleteSession(const std::string& session_id);
+    // Mark session as complete (no more chunks coming). A non-empty `error`
+    // says why the chunks are not the full answer; the final response to the
+    // client carries it.
+    void CompleteSession(const std::string& session_id, const std::string& error = "");
     
     // Cleanup session data
     void CleanupSession(const std::string& session_id);
@@ -41,19 +84,92 @@ public:
     void StopCleanupThread();
 
 private:
+    struct Chunk {
+        std::string payload;       // in memory; empty once released or if spilled
+        bool spilled = false;      // payload lives in Session::spill instead
+                                   // (and in `payload` too once read ahead)
+        uint64_t spill_offset = 0;
+        size_t spill_length = 0;
+    };
+
     struct Session {
         std::string request_id;
-        std::vector<mini2::WorkerResult> chunks;
+        std::vector<Chunk> chunks;
+        std::unique_ptr<SpillSegment> spill;  // created on first spill
+        uint32_t released = 0;         // chunks [0, released) have been dropped
+        size_t buffered_bytes = 0;     // payload bytes still held in memory
+        size_t spilled_bytes = 0;      // ... and in the segment
         bool complete = false;
+        std::string error;             // set with complete
+        bool closed = false;           // erased; waiting producers give up
         uint32_t next_poll_index = 0;  // For PollNext tracking
+        uint32_t next_expected = 0;    // index an in-order GetNext reader asks for next
+        uint32_t sequential_run = 0;   // GetNext calls in a row that hit next_expected
+        uint32_t read_ahead_upto = 0;  // read-ahead wants chunks before this in memory
+        bool read_ahead_queued = false;
         std::chrono::steady_clock::time_point created_at;
         std::chrono::steady_clock::time_point last_access;  // Track last access for timeout
         std::mutex mutex;
         std::condition_variable cv;  // For blocking GetNext
     };
     
-    std::map<std::string, Session> sessions_;
-    std::mutex sessions_mutex_;
+    // shared_ptr so a thread blocked on a session survives its erasure
+    using SessionTable = std::unordered_map<std::string, std::shared_ptr<Session>>;
+    struct Shard {
+        std::mutex mutex;      // guards sessions and each Session::last_access
+        SessionTable sessions;
+    };
+    std::vector<Shard> shards_;
+
+    Shard& ShardFor(const std::string& session_id);
+
+    size_t session_budget_bytes_ = 256ull << 20;
+    size_t total_budget_bytes_ = 1ull << 30;
+    std::atomic<size_t> total_buffered_bytes_{0};
+
+    std::string spill_dir_ = "/tmp";
+    size_t spill_watermark_bytes_ = 0;
+    std::atomic<size_t> total_spilled_bytes_{0};
+
+    uint32_t read_ahead_chunks_ = 4;
+    std::thread read_ahead_thread_;
+    std::mutex read_ahead_mutex_;
+    std::condition_variable read_ahead_cv_;
+    std::deque<std::weak_ptr<Session>> read_ahead_queue_;  // guarded by read_ahead_mutex_
+    bool read_ahead_running_ = false;                      // ditto
+
+    // Note a served GetNext(index) and, if the reader is sequential, queue
+    // the chunks after it for read-ahead. Caller holds session->mutex.
+    void TrackAccess(const std::shared_ptr<Session>& session, uint32_t index, uint32_t window);
+
+    // Background thread: pull queued sessions' upcoming spilled chunks back
+    // into memory
+    void ReadAheadThreadFunc();
+    void ReadAhead(Session& session);
+
+    // Write `payload` to the session's segment; false if spilling failed
+    // (the chunk then stays in memory). Caller holds session.mutex.
+    bool SpillChunk(Session& session, std::string& payload, Chunk* chunk);
+
+    // Copy chunk `index` into `out` (from memory or the segment), hinting the
+    // kernel to read ahead the next few spilled chunks. Caller holds
+    // session.mutex.
+    bool ReadChunk(Session& session, uint32_t index, std::string* out);
+
+    // `touch` counts as client activity for the stale-session timeout
+    std::shared_ptr<Session> FindSession(const std::string& session_id, bool touch);
+
+    // Drop chunks [session.released, upto); caller holds session.mutex
+    void ReleaseChunks(Session& session, uint32_t upto);
+    // Add `bytes` to the node-wide total unless that takes it past `limit`
+    bool ReserveBuffered(size_t bytes, size_t limit);
+    void Unbuffer(Session& session, size_t bytes);
+
+    // Give back what a session taken out of its shard holds and wake anyone
+    // blocked on it. Takes session.mutex, which is held across spill I/O,
+    // so never call it under a shard lock: every lookup in the shard would
+    // wait behind that I/O.
+    void CloseSession(Session& session);
     
     // Cleanup thread management
     std::thread cleanup_thread_;
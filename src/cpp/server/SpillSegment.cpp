@@ -0,0 +1,147 @@
+#include "SpillSegment.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MINI2_HAVE_MMAP 1
+#endif
+
+namespace {
+constexpr size_t kMinMapping = 1 << 20;
+}
+
+std::unique_ptr<SpillSegment> SpillSegment::Create(const std::string& dir, std::string* error) {
+#ifdef MINI2_HAVE_MMAP
+    // `dir` may be shared (the default is /tmp), so never open a name someone
+    // else could have planted: an anonymous O_TMPFILE where the filesystem
+    // supports it, otherwise a fresh mkstemp name (O_EXCL, so an existing
+    // file or symlink there is a failure, not a target)
+    int fd = -1;
+#ifdef O_TMPFILE
+    fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+#endif
+    if (fd < 0) {
+        std::string path = dir + "/mini2-XXXXXX";
+        fd = ::mkstemp(&path[0]);
+        if (fd < 0) {
+            if (error) *error = path + ": " + std::strerror(errno);
+            return nullptr;
+        }
+        ::unlink(path.c_str());  // Lives on through fd/mapping only
+    }
+    return std::unique_ptr<SpillSegment>(new SpillSegment(fd));
+#else
+    if (error) *error = "spilling needs mmap";
+    return nullptr;
+#endif
+}
+
+SpillSegment::~SpillSegment() {
+#ifdef MINI2_HAVE_MMAP
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool SpillSegment::Append(std::string_view data, uint64_t* offset) {
+#ifdef MINI2_HAVE_MMAP
+    const char* p = data.data();
+    size_t left = data.size();
+    uint64_t at = size_;
+    while (left > 0) {
+        ssize_t n = ::pwrite(fd_, p, left, static_cast<off_t>(at));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        at += static_cast<uint64_t>(n);
+        left -= static_cast<size_t>(n);
+    }
+    *offset = size_;
+    size_ = at;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SpillSegment::Remap() {
+#ifdef MINI2_HAVE_MMAP
+    size_t capacity = std::max(kMinMapping, mapping_size_ * 2);
+    while (capacity < size_) {
+        capacity *= 2;
+    }
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+    // The part past EOF is never touched (reads stop at size_); with
+    // MAP_SHARED it shows what later appends write there
+    void* addr = ::mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    // Chunks are served front to back
+    ::madvise(addr, capacity, MADV_SEQUENTIAL);
+    mapping_ = static_cast<char*>(addr);
+    mapping_size_ = capacity;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SpillSegment::Read(uint64_t offset, size_t length, std::string* out) {
+    if (offset + length > size_) {
+        return false;
+    }
+    if (offset + length > mapping_size_ && !Remap()) {
+        return false;
+    }
+    out->assign(mapping_ + offset, length);
+    return true;
+}
+
+void SpillSegment::WillNeed(uint64_t offset, size_t length) {
+#ifdef MINI2_HAVE_MMAP
+    if (offset + length > mapping_size_ && !Remap()) {
+        return;
+    }
+    // madvise wants a page-aligned start
+    const uint64_t page = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    const uint64_t start = offset / page * page;
+    ::madvise(mapping_ + start, static_cast<size_t>(offset + length - start), MADV_WILLNEED);
+#endif
+}
+
+uint64_t SpillSegment::DiskBytes() const {
+#ifdef MINI2_HAVE_MMAP
+    struct stat st;
+    if (::fstat(fd_, &st) == 0) {
+        return static_cast<uint64_t>(st.st_blocks) * 512;
+    }
+#endif
+    return 0;
+}
+
+void SpillSegment::Discard(uint64_t offset, size_t length) {
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    ::fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                static_cast<off_t>(offset), static_cast<off_t>(length));
+#else
+    (void)offset;
+    (void)length;
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Append-only file of session chunk payloads that no longer fit in memory,
+// read back through a read-only mapping. The file has no name (or loses it
+// right after it is created), so the disk space goes away with the segment
+// (or the process).
+// Not thread-safe; the owning session serializes access.
+class SpillSegment {
+public:
+    // A new segment in `dir`; nullptr (and `error` set) if the file can't be
+    // created or this platform has no mmap
+    static std::unique_ptr<SpillSegment> Create(const std::string& dir, std::string* error);
+    ~SpillSegment();
+
+    SpillSegment(const SpillSegment&) = delete;
+    SpillSegment& operator=(const SpillSegment&) = delete;
+
+    // Write `data` at the end of the file; its position goes to `offset`
+    bool Append(std::string_view data, uint64_t* offset);
+
+    // Copy [offset, offset + length) out of the file
+    bool Read(uint64_t offset, size_t length, std::string* out);
+
+    // Ask the kernel to start reading a range we are about to serve
+    void WillNeed(uint64_t offset, size_t length);
+
+    // Give the disk blocks of a served range back (where supported)
+    void Discard(uint64_t offset, size_t length);
+
+    uint64_t Size() const { return size_; }
+
+    // Bytes the file occupies on disk, which Discard gives back
+    uint64_t DiskBytes() const;
+
+private:
+    explicit SpillSegment(int fd) : fd_(fd) {}
+
+    // Map the file with room to grow: the mapping at least doubles each
+    // time, so a segment appended to between reads is remapped O(log size)
+    // times rather than on every append
+    bool Remap();
+
+    int fd_ = -1;
+    uint64_t size_ = 0;
+    char* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
@@ -1,13 +1,28 @@
 #include "WorkerQueue.h"
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 
-WorkerQueue::WorkerQueue(const std::string& node_id, int num_threads)
+namespace {
+// Lane of the current thread when it is one of a pool's workers
+thread_local const WorkerQueue* tls_pool = nullptr;
+thread_local int tls_lane = -1;
+}
+
+WorkerQueue::WorkerQueue(const std::string& node_id, int num_threads, size_t max_queue)
     : node_id_(node_id)
-    , num_threads_(num_threads)
+    , num_threads_(std::max(1, num_threads))
+    , max_queue_(std::max<size_t>(1, max_queue))
+    , next_lane_(0)
+    , sleeping_(0)
     , running_(false)
+    , pending_(0)
     , active_workers_(0)
-    , requests_processed_(0) {
+    , requests_processed_(0)
+    , requests_rejected_(0)
+    , requests_stolen_(0) {
+    for (int i = 0; i < num_threads_; ++i) {
+        lanes_.push_back(std::make_unique<Lane>());
+    }
 }
 
 WorkerQueue::~WorkerQueue() {
@@ -16,153 +31,138 @@ WorkerQueue::~WorkerQueue() {
 
 void WorkerQueue::Start() {
     if (running_) return;
-    
+
     running_ = true;
-    std::cout << "[WorkerQueue:" << node_id_ << "] Starting " << num_threads_ << " worker threads" << std::endl;
-    
+    std::cout << "[WorkerQueue:" << node_id_ << "] Starting " << num_threads_
+              << " worker threads (max queue " << max_queue_ << ")" << std::endl;
+
     for (int i = 0; i < num_threads_; ++i) {
         worker_threads_.emplace_back(&WorkerQueue::WorkerThreadFunc, this, i);
     }
 }
 
 void WorkerQueue::Stop() {
-    if (!running_) return;
-    
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+
     std::cout << "[WorkerQueue:" << node_id_ << "] Stopping worker threads..." << std::endl;
-    running_ = false;
-    queue_cv_.notify_all();
-    
+    sleep_cv_.notify_all();
+
     for (auto& thread : worker_threads_) {
         if (thread.joinable()) {
             thread.join();
         }
     }
-    
+
     worker_threads_.clear();
-    std::cout << "[WorkerQueue:" << node_id_ << "] All worker threads stopped. Processed " 
-              << requests_processed_ << " requests." << std::endl;
+    std::cout << "[WorkerQueue:" << node_id_ << "] All worker threads stopped. Processed "
+              << requests_processed_ << " requests (" << requests_stolen_ << " stolen), rejected "
+              << requests_rejected_ << "." << std::endl;
 }
 
-void WorkerQueue::EnqueueRequest(const mini2::Request& req, WorkCompletedCallback callback) {
-    WorkItem item;
-    item.request = req;
-    item.callback = callback;
-    item.enqueue_time = std::chrono::steady_clock::now();
-    
+bool WorkerQueue::EnqueueRequest(const mini2::Request& req, RequestHandler handler) {
+    // Reserve a slot first so the bound holds without a shared lock
+    size_t depth = pending_.load();
+    do {
+        if (!running_ || depth >= max_queue_) {
+            requests_rejected_++;
+            std::cerr << "[WorkerQueue:" << node_id_ << "] Rejected request: " << req.request_id()
+                      << (running_ ? " (queue full)" : " (stopped)") << std::endl;
+            return false;
+        }
+    } while (!pending_.compare_exchange_weak(depth, depth + 1));
+
+    // Stop() may have cleared running_ after the check above, and its workers
+    // exit once they see pending_ == 0. Seen from here, either the workers
+    // will see this reservation before exiting, or running_ is already false
+    // and it is taken back.
+    if (!running_) {
+        pending_--;
+        requests_rejected_++;
+        std::cerr << "[WorkerQueue:" << node_id_ << "] Rejected request: " << req.request_id()
+                  << " (stopped)" << std::endl;
+        return false;
+    }
+
+    int lane = (tls_pool == this) ? tls_lane
+                                  : static_cast<int>(next_lane_.fetch_add(1) % lanes_.size());
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        work_queue_.push(std::move(item));
+        std::lock_guard<std::mutex> lock(lanes_[lane]->mutex);
+        lanes_[lane]->items.push_back(WorkItem{req, std::move(handler)});
     }
-    
-    queue_cv_.notify_one();
-    
-    std::cout << "[WorkerQueue:" << node_id_ << "] Enqueued request: " << req.request_id() 
-              << " (queue size: " << GetQueueSize() << ")" << std::endl;
-}
 
-void WorkerQueue::SetDataProcessor(std::shared_ptr<DataProcessor> processor) {
-    data_processor_ = processor;
+    // Sleepers re-check pending_ under sleep_mutex_ before waiting, so taking
+    // the lock here is only needed when one might be parked
+    if (sleeping_ > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_one();
+    }
+    return true;
 }
 
-size_t WorkerQueue::GetQueueSize() const {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    return work_queue_.size();
+bool WorkerQueue::IsIdle() const {
+    return pending_ == 0 && active_workers_ == 0;
 }
 
-bool WorkerQueue::IsIdle() const {
-    return GetQueueSize() == 0 && active_workers_ == 0;
+bool WorkerQueue::TakeWork(int lane, WorkItem* item) {
+    const int lanes = static_cast<int>(lanes_.size());
+    for (int i = 0; i < lanes; ++i) {
+        Lane& victim = *lanes_[(lane + i) % lanes];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.items.empty()) {
+            continue;
+        }
+        // Oldest first from any lane: requests are independent, so FIFO
+        // keeps waiting time fair across clients
+        *item = std::move(victim.items.front());
+        victim.items.pop_front();
+        pending_--;
+        if (i > 0) {
+            requests_stolen_++;
+        }
+        return true;
+    }
+    return false;
 }
 
 void WorkerQueue::WorkerThreadFunc(int thread_id) {
-    std::cout << "[WorkerQueue:" << node_id_ << "] Thread " << thread_id << " started" << std::endl;
-    
-    while (running_) {
+    tls_pool = this;
+    tls_lane = thread_id;
+
+    while (true) {
         WorkItem item;
-        
-        // Wait for work
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait(lock, [this] { 
-                return !work_queue_.empty() || !running_; 
-            });
-            
-            if (!running_ && work_queue_.empty()) {
+
+        if (!TakeWork(thread_id, &item)) {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleeping_++;
+            // pending_ can run ahead of the lanes while an enqueue is between
+            // reserving and pushing; that just means another pass
+            sleep_cv_.wait(lock, [this] { return pending_ > 0 || !running_; });
+            sleeping_--;
+
+            // Drain what was accepted before stopping
+            if (!running_ && pending_ == 0) {
                 break;
             }
-            
-            if (work_queue_.empty()) {
-                continue;
-            }
-            
-            item = std::move(work_queue_.front());
-            work_queue_.pop();
-        }
-        
-        // Process work
-        active_workers_++;
-        
-        auto start_time = std::chrono::steady_clock::now();
-        auto wait_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-            start_time - item.enqueue_time).count();
-        
-        std::cout << "[WorkerQueue:" << node_id_ << "][Thread " << thread_id << "] "
-                  << "Processing request: " << item.request.request_id() 
-                  << " (waited " << wait_time << "ms)" << std::endl;
-        
-        mini2::WorkerResult result = ProcessRequest(item.request);
-        
-        auto end_time = std::chrono::steady_clock::now();
-        auto process_time = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end_time - start_time).count();
-        
-        std::cout << "[WorkerQueue:" << node_id_ << "][Thread " << thread_id << "] "
-                  << "Completed request: " << item.request.request_id() 
-                  << " (took " << process_time << "ms)" << std::endl;
-        
-        requests_processed_++;
-        active_workers_--;
-        
-        // Invoke callback with result
-        if (item.callback) {
-            item.callback(result);
+            continue;
         }
-    }
-    
-    std::cout << "[WorkerQueue:" << node_id_ << "] Thread " << thread_id << " stopped" << std::endl;
-}
 
-mini2::WorkerResult WorkerQueue::ProcessRequest(const mini2::Request& req) {
-    mini2::WorkerResult result;
-    result.set_request_id(req.request_id());
-    result.set_part_index(0);
-    
-    // If we have a data processor and query is a file path, process real data
-    if (data_processor_ && !req.query().empty()) {
+        active_workers_++;
         try {
-            // Get all data (or chunk based on team assignment)
-            size_t total_rows = data_processor_->GetTotalRows();
-            auto chunk = data_processor_->GetChunk(0, total_rows);
-            
-            // Serialize chunk to bytes
-            std::ostringstream oss;
-            oss << data_processor_->GetHeader() << "\n";
-            for (const auto& row : chunk) {
-                oss << row.GetRaw() << "\n";
+            if (item.handler) {
+                item.handler(item.request);
             }
-            
-            std::string data = oss.str();
-            result.set_payload(data);
-            
-            std::cout << "[WorkerQueue:" << node_id_ << "] Processed " << chunk.size() 
-                      << " rows (" << data.size() << " bytes)" << std::endl;
         } catch (const std::exception& e) {
-            std::cerr << "[WorkerQueue:" << node_id_ << "] Error processing data: " << e.what() << std::endl;
-            result.set_payload("ERROR: " + std::string(e.what()));
+            std::cerr << "[WorkerQueue:" << node_id_ << "] Error processing "
+                      << item.request.request_id() << ": " << e.what() << std::endl;
         }
-    } else {
-        // No data loaded or empty query
-        result.set_payload("");
+        requests_processed_++;
+        active_workers_--;
     }
-    
-    return result;
+
+    tls_pool = nullptr;
+    tls_lane = -1;
 }
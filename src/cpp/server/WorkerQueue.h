@@ -1,62 +1,84 @@
 #pragma once
 
 #include "minitwo.grpc.pb.h"
-#include "DataProcessor.h"
-#include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <memory>
+#include <chrono>
 #include <functional>
+#include <string>
+#include <vector>
 
-// Callback type for completed work
-using WorkCompletedCallback = std::function<void(const mini2::WorkerResult&)>;
+// Work to run for an accepted request (on a queue thread)
+using RequestHandler = std::function<void(const mini2::Request&)>;
 
+// Work-stealing pool for ingress requests, so gRPC handlers can ack
+// immediately and long-running work (team leaders waiting on workers, worker
+// scans) never holds a gRPC thread.
+//
+// Each thread owns a lane (a deque behind its own mutex). Submissions from
+// outside the pool are spread round-robin over the lanes; submissions made by
+// a handler go to its own lane. A thread whose lane is empty steals from its
+// peers before going to sleep, so no single lock is shared by every enqueue
+// and dequeue. The total backlog is still bounded by max_queue.
 class WorkerQueue {
 public:
-    WorkerQueue(const std::string& node_id, int num_threads = 2);
+    WorkerQueue(const std::string& node_id, int num_threads = 2, size_t max_queue = 64);
     ~WorkerQueue();
-    
+
     // Start processing threads
     void Start();
-    
-    // Stop processing (graceful)
+
+    // Stop processing (graceful: queued work is finished first)
     void Stop();
-    
-    // Enqueue a request (non-blocking)
-    void EnqueueRequest(const mini2::Request& req, WorkCompletedCallback callback);
-    
-    // Set data processor for real data
-    void SetDataProcessor(std::shared_ptr<DataProcessor> processor);
-    
+
+    // Enqueue a request (non-blocking). Returns false when the queue is full
+    // or stopped; the caller should reject the request.
+    bool EnqueueRequest(const mini2::Request& req, RequestHandler handler);
+
     // Get queue status
-    size_t GetQueueSize() const;
+    size_t GetQueueSize() const { return pending_; }
     bool IsIdle() const;
     int GetProcessedCount() const { return requests_processed_; }
+    int GetRejectedCount() const { return requests_rejected_; }
+    uint64_t GetStolenCount() const { return requests_stolen_; }
 
 private:
     struct WorkItem {
         mini2::Request request;
-        WorkCompletedCallback callback;
-        std::chrono::steady_clock::time_point enqueue_time;
+        RequestHandler handler;
+    };
+
+    struct Lane {
+        std::mutex mutex;
+        std::deque<WorkItem> items;
     };
-    
+
     std::string node_id_;
     int num_threads_;
+    size_t max_queue_;
     std::vector<std::thread> worker_threads_;
-    std::queue<WorkItem> work_queue_;
-    mutable std::mutex queue_mutex_;
-    std::condition_variable queue_cv_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::atomic<size_t> next_lane_;
+
+    // Idle threads park here; only touched when someone is (or may be) asleep
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<int> sleeping_;
+
     std::atomic<bool> running_;
+    std::atomic<size_t> pending_;   // accepted, not yet picked up
     std::atomic<int> active_workers_;
     std::atomic<int> requests_processed_;
-    
-    std::shared_ptr<DataProcessor> data_processor_;
-    
+    std::atomic<int> requests_rejected_;
+    std::atomic<uint64_t> requests_stolen_;
+
+    // Pop from our own lane, else steal from the others
+    bool TakeWork(int lane, WorkItem* item);
+
     // Worker thread function
     void WorkerThreadFunc(int thread_id);
-    
-    // Process a single request
-    mini2::WorkerResult ProcessRequest(const mini2::Request& req);
 };
@@ -0,0 +1,110 @@
+// Contention benchmark for the SessionManager table: T client threads each
+// call GetNextChunk / PollNextChunk on their own sessions as fast as they
+// can. Run with one shard (a single table lock) and with the default shard
+// count to see the difference.
+//
+//   bench_sessions [--sessions N] [--seconds S] [--chunk-bytes B]
+#include "SessionManager.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+double RunOnce(size_t shards, int threads, int sessions, double seconds, size_t chunk_bytes) {
+    SessionManager manager(shards);
+
+    // GetNext re-reads chunk 0 of a session holding one small chunk; polls go
+    // to sessions that completed empty, so they return straight away and
+    // never release anything
+    std::vector<std::string> ids, empty_ids;
+    mini2::Request req;
+    for (int i = 0; i < sessions; ++i) {
+        ids.push_back(manager.CreateSession(req));
+        mini2::WorkerResult result;
+        result.set_payload(std::string(chunk_bytes, 'x'));
+        manager.AddChunk(ids.back(), std::move(result));
+        manager.CompleteSession(ids.back());
+
+        empty_ids.push_back(manager.CreateSession(req));
+        manager.CompleteSession(empty_ids.back());
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> ops{0};
+    std::vector<std::thread> clients;
+    for (int t = 0; t < threads; ++t) {
+        clients.emplace_back([&, t] {
+            uint64_t local = 0;
+            for (size_t i = t; !stop; i += threads) {
+                mini2::NextChunkResp next;
+                manager.GetNextChunk(ids[i % ids.size()], 0, &next);
+                mini2::PollResp poll;
+                manager.PollNextChunk(empty_ids[i % empty_ids.size()], &poll);
+                local += 2;
+            }
+            ops += local;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& c : clients) c.join();
+    return ops / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int sessions = 1024;
+    double seconds = 1.0;
+    size_t chunk_bytes = 1024;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--sessions" && i + 1 < argc) sessions = std::stoi(argv[++i]);
+        else if (a == "--seconds" && i + 1 < argc) seconds = std::stod(argv[++i]);
+        else if (a == "--chunk-bytes" && i + 1 < argc) chunk_bytes = std::stoul(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--sessions N] [--seconds S] [--chunk-bytes B]" << std::endl;
+            return 1;
+        }
+    }
+    sessions = std::max(1, sessions);
+
+    // SessionManager logs every call; keep that out of the measurement
+    std::streambuf* console = std::cout.rdbuf(nullptr);
+    auto report = [console](const std::string& line) {
+        std::streambuf* quiet = std::cout.rdbuf(console);
+        std::cout << line << std::endl;
+        std::cout.rdbuf(quiet);
+    };
+
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> thread_counts;
+    for (int t = 1; t < cores; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(cores);
+    thread_counts.push_back(cores * 4);  // more clients than cores, as on A
+
+    report("sessions=" + std::to_string(sessions) + " chunk=" + std::to_string(chunk_bytes) +
+           "B cores=" + std::to_string(cores));
+    std::ostringstream header;
+    header << std::setw(8) << "threads" << std::setw(16) << "1 shard ops/s" << std::setw(18)
+           << (std::to_string(SessionManager::kDefaultShards) + " shards ops/s") << std::setw(10) << "ratio";
+    report(header.str());
+
+    for (int threads : thread_counts) {
+        double single = RunOnce(1, threads, sessions, seconds, chunk_bytes);
+        double sharded = RunOnce(SessionManager::kDefaultShards, threads, sessions, seconds, chunk_bytes);
+        std::ostringstream line;
+        line << std::setw(8) << threads << std::setw(16) << static_cast<uint64_t>(single) << std::setw(18)
+             << static_cast<uint64_t>(sharded) << std::setw(9) << std::fixed << std::setprecision(2)
+             << sharded / single << "x";
+        report(line.str());
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Microbenchmark for the ingress WorkerQueue: several producer threads (standing
+// in for gRPC handler threads) submit small CPU-bound jobs, and we report jobs/s
+// for pool sizes 1, 2, 4, ... up to the core count.
+//
+//   bench_worker_queue [--jobs N] [--producers P] [--work-us U]
+#include "WorkerQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Burn roughly `us` microseconds of CPU without touching shared state
+void Spin(int us) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    volatile double x = 1.0;
+    while (std::chrono::steady_clock::now() < until) {
+        for (int i = 0; i < 64; ++i) x = std::sqrt(x + i);
+    }
+}
+
+double RunOnce(int threads, int producers, int jobs, int work_us, uint64_t* stolen) {
+    WorkerQueue queue("bench", threads, static_cast<size_t>(jobs));
+    queue.Start();
+
+    std::atomic<int> done{0};
+    mini2::Request req;
+    req.set_request_id("bench");
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> submitters;
+    for (int p = 0; p < producers; ++p) {
+        int share = jobs / producers + (p < jobs % producers ? 1 : 0);
+        submitters.emplace_back([&, share] {
+            for (int i = 0; i < share; ++i) {
+                while (!queue.EnqueueRequest(req, [&done, work_us](const mini2::Request&) {
+                    if (work_us > 0) Spin(work_us);
+                    done++;
+                })) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : submitters) t.join();
+    while (done < jobs) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    *stolen = queue.GetStolenCount();
+    queue.Stop();
+    return jobs / secs;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int jobs = 200000;
+    int producers = 4;
+    int work_us = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--jobs" && i + 1 < argc) jobs = std::stoi(argv[++i]);
+        else if (a == "--producers" && i + 1 < argc) producers = std::stoi(argv[++i]);
+        else if (a == "--work-us" && i + 1 < argc) work_us = std::stoi(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--jobs N] [--producers P] [--work-us U]" << std::endl;
+            return 1;
+        }
+    }
+    producers = std::max(1, producers);
+
+    int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> sizes;
+    for (int t = 1; t < cores; t *= 2) sizes.push_back(t);
+    sizes.push_back(cores);
+
+    std::cout << "jobs=" << jobs << " producers=" << producers << " work=" << work_us
+              << "us cores=" << cores << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "jobs/s" << std::setw(10) << "speedup"
+              << std::setw(10) << "stolen" << std::endl;
+
+    double base = 0;
+    for (int threads : sizes) {
+        uint64_t stolen = 0;
+        double rate = RunOnce(threads, producers, jobs, work_us, &stolen);
+        if (base == 0) base = rate;
+        std::cout << std::setw(8) << threads << std::setw(14) << static_cast<uint64_t>(rate)
+                  << std::setw(9) << std::fixed << std::setprecision(2) << rate / base << "x"
+                  << std::setw(10) << stolen << std::endl;
+    }
+    return 0;
+}
@@ -1,9 +1,58 @@
 
+// Checks run (and have side effects) in every build type
+#undef NDEBUG
 #include <cassert>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <random>
+#include <string>
+#include <vector>
 #include "../src/cpp/common/config.h"
+#include "../src/cpp/common/ColumnBatch.h"
+#include "../src/cpp/server/CsvScanner.h"
+#include "../src/cpp/server/ColumnStore.h"
+#include "../src/cpp/server/DataProcessor.h"
+#include "../src/cpp/server/RowFilter.h"
+#include "../src/cpp/server/Aggregator.h"
+#include "../src/cpp/server/SessionManager.h"
+#include "../src/cpp/server/SpillSegment.h"
+#include "../src/cpp/server/WorkerQueue.h"
+#include "../src/cpp/server/Handlers.cpp"  // services, as ServerMain builds them
 
-int main(){
+std::atomic<bool> g_shutdown_requested(false);
+
+// Byte-at-a-time split with the same quoting rules, to check the block scanner against
+static std::vector<std::string> ReferenceSplit(const std::string& line, char delimiter) {
+    std::vector<std::string> out;
+    std::string field;
+    bool in_quotes = false;
+    for (char c : line) {
+        if (c == '"') in_quotes = !in_quotes;
+        if (c == delimiter && !in_quotes) {
+            out.push_back(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    out.push_back(field);
+    for (auto& f : out) {
+        if (f.size() >= 2 && f.front() == '"' && f.back() == '"') f = f.substr(1, f.size() - 2);
+    }
+    return out;
+}
+
+static void TestConfig() {
     std::vector<std::string> paths = {"config/network_setup.json", "../config/network_setup.json"};
     NetworkConfig cfg;
     bool loaded = false;
@@ -18,8 +67,677 @@ int main(){
     }
     if (!loaded) {
         std::cerr << "Failed to load config" << std::endl;
-        return 1;
+        std::exit(1);
     }
     assert(cfg.nodes.size()==6);
+}
+
+static void TestCsvScanner() {
+    std::vector<std::string_view> fields;
+
+    // Quoted field with embedded delimiters; doubled quotes are left as-is
+    std::string line = "1,\"Fresno, CA\",\"say \"\"hi\"\", ok\",,last";
+    assert(csv::SplitFields(line, ',', fields) == 5);
+    assert(fields[0] == "1");
+    assert(fields[1] == "Fresno, CA");
+    assert(fields[2] == "say \"\"hi\"\", ok");
+    assert(fields[3].empty());
+    assert(fields[4] == "last");
+    for (size_t i = 0; i < fields.size(); ++i) {
+        assert(csv::FieldAt(line, i) == fields[i]);
+    }
+    assert(csv::FieldAt(line, 5).empty());
+
+    // A quoted field straddling the 16- and 32-byte block edges
+    std::string wide = std::string(14, 'x') + ",\"" + std::string(10, 'y') + ",in,quotes," + std::string(12, 'z') + "\",tail";
+    assert(csv::SplitFields(wide, ',', fields) == 3);
+    assert(fields[1] == std::string(10, 'y') + ",in,quotes," + std::string(12, 'z'));
+    assert(csv::FieldAt(wide, 2) == "tail");
+
+    // Block and tail paths agree with a byte-at-a-time split at every length
+    std::mt19937 rng(7);
+    const char alphabet[] = "ab,\"";
+    for (int n = 0; n < 2000; ++n) {
+        std::string text;
+        const size_t len = rng() % 100;
+        for (size_t i = 0; i < len; ++i) text += alphabet[rng() % 4];
+        auto expected = ReferenceSplit(text, ',');
+        assert(csv::SplitFields(text, ',', fields) == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            assert(fields[i] == expected[i]);
+            assert(csv::FieldAt(text, i) == expected[i]);
+        }
+    }
+
+    std::string rows = std::string(40, 'r') + "\n" + "next";
+    assert(csv::FindNewline(rows.data(), rows.data() + rows.size()) == rows.data() + 40);
+    assert(csv::FindNewline(rows.data() + 41, rows.data() + rows.size()) == rows.data() + rows.size());
+
+    // Writing a split field back: quoted only when needed, and a field that
+    // came from quotes reads back unchanged
+    auto written = [](std::string_view field) {
+        std::string out;
+        csv::AppendField(out, field);
+        return out;
+    };
+    assert(written("plain") == "plain");
+    assert(written("") == "");
+    assert(written("Fresno, CA") == "\"Fresno, CA\"");
+    assert(written("say \"\"hi\"\", ok") == "\"say \"\"hi\"\", ok\"");  // as split above
+    assert(written("5\" pipe") == "\"5\"\" pipe\"");
+    assert(written("two\nlines") == "\"two\nlines\"");
+    const std::string rewritten = written("say \"\"hi\"\", ok");
+    assert(csv::SplitFields(rewritten, ',', fields) == 1 && fields[0] == "say \"\"hi\"\", ok");
+}
+
+// Row indices of `rows` matching `preds`; false if the filter doesn't compile
+static bool FilterRows(const std::vector<FilterPredicate>& preds, const Schema& schema,
+                       const ColumnStore* store, const std::vector<CSVRow>& rows,
+                       std::vector<size_t>* matched) {
+    RowFilter filter;
+    std::string error;
+    if (!filter.Compile(preds, schema, store, &error)) {
+        return false;
+    }
+    matched->clear();
+    for (const auto& row : rows) {
+        if (filter.Matches(row)) matched->push_back(row.Index());
+    }
+    return true;
+}
+
+static void TestRowFilter() {
+    using Op = FilterPredicate::Op;
+    const std::string header = "Latitude,UTC,Parameter,AQI,Note";
+    const std::vector<std::string> lines = {
+        "36.1,1/2/20 10:00,PM2.5,10,\"a, b\"",
+        "36.5,1/2/20 11:00,OZONE,20,plain",
+        "37.0,1/3/20 10:00,PM2.5,30,zz",
+        "37.5,bad,NO2,40,plain",  // malformed timestamp: missing, so no comparison matches
+    };
+    std::vector<CSVRow> rows;
+    for (size_t i = 0; i < lines.size(); ++i) rows.emplace_back(lines[i], i);
+    Schema schema(header);
+    ColumnStore store;
+    store.Build(schema, rows, 1);
+
+    struct Case {
+        std::string column;
+        Op op;
+        std::vector<std::string> values;
+        std::vector<size_t> expected;
+    };
+    const std::vector<Case> cases = {
+        // Int32: StoredNumber with the column store, ParsedNumber without
+        {"AQI", Op::Eq, {"20"}, {1}},
+        {"AQI", Op::Ne, {"20"}, {0, 2, 3}},
+        {"AQI", Op::Lt, {"20"}, {0}},
+        {"AQI", Op::Le, {"20"}, {0, 1}},
+        {"AQI", Op::Gt, {"20"}, {2, 3}},
+        {"AQI", Op::Ge, {"20"}, {1, 2, 3}},
+        {"AQI", Op::Between, {"15", "30"}, {1, 2}},
+        {"AQI", Op::In, {"10", "40"}, {0, 3}},
+        {"Latitude", Op::Gt, {"36.5"}, {2, 3}},
+        {"UTC", Op::Lt, {"1/3/20 0:00"}, {0, 1}},
+        {"UTC", Op::Ge, {"1/3/20 0:00"}, {2}},
+        // Dictionary: DictionaryCodes with the column store, Text without
+        {"Parameter", Op::Eq, {"PM2.5"}, {0, 2}},
+        {"Parameter", Op::Ne, {"PM2.5"}, {1, 3}},
+        {"Parameter", Op::Lt, {"OZONE"}, {3}},
+        {"Parameter", Op::Le, {"OZONE"}, {1, 3}},
+        {"Parameter", Op::Gt, {"OZONE"}, {0, 2}},
+        {"Parameter", Op::Ge, {"OZONE"}, {0, 1, 2}},
+        {"Parameter", Op::Between, {"NO2", "OZONE"}, {1, 3}},
+        {"Parameter", Op::In, {"OZONE", "NO2"}, {1, 3}},
+        {"Parameter", Op::Eq, {"CO"}, {}},
+        // String: Text either way
+        {"Note", Op::Eq, {"a, b"}, {0}},
+        {"Note", Op::Ne, {"plain"}, {0, 2}},
+        {"Note", Op::Lt, {"plain"}, {0}},
+        {"Note", Op::Le, {"plain"}, {0, 1, 3}},
+        {"Note", Op::Gt, {"plain"}, {2}},
+        {"Note", Op::Ge, {"plain"}, {1, 2, 3}},
+        {"Note", Op::Between, {"b", "q"}, {1, 3}},
+        {"Note", Op::In, {"zz", "a, b"}, {0, 2}},
+    };
+    std::vector<size_t> matched;
+    for (const auto& c : cases) {
+        std::vector<FilterPredicate> preds(1);
+        preds[0].column = c.column;
+        preds[0].op = c.op;
+        preds[0].values = c.values;
+        for (const ColumnStore* columns : {static_cast<const ColumnStore*>(&store), static_cast<const ColumnStore*>(nullptr)}) {
+            assert(FilterRows(preds, schema, columns, rows, &matched));
+            assert(matched == c.expected);
+        }
+    }
+
+    // Conjunction
+    std::vector<FilterPredicate> both(2);
+    both[0] = {"Parameter", Op::Eq, {"PM2.5"}};
+    both[1] = {"AQI", Op::Gt, {"10"}};
+    assert(FilterRows(both, schema, &store, rows, &matched) && matched == std::vector<size_t>{2});
+
+    // Malformed literals and bad predicates fail to compile
+    const std::vector<FilterPredicate> bad = {
+        {"UTC", Op::Eq, {"1/2/20"}},
+        {"UTC", Op::Lt, {"soon"}},
+        {"AQI", Op::Eq, {"abc"}},
+        {"Nope", Op::Eq, {"1"}},
+        {"AQI", Op::Between, {"1"}},
+    };
+    for (const auto& pred : bad) {
+        assert(!FilterRows({pred}, schema, &store, rows, &matched));
+        assert(!FilterRows({pred}, schema, nullptr, rows, &matched));
+    }
+}
+
+// Writes `text` to a scratch file and returns its path
+static std::string WriteTempFile(const std::string& name, const std::string& text) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary) << text;
+    return path.string();
+}
+
+static void TestAggregatorMerge() {
+    const std::string path = WriteTempFile("mini2_agg_test.csv",
+        "Parameter,AQI,Site Name\n"
+        "PM2.5,10,S1\n"
+        "PM2.5,30,S2\n"
+        "OZONE,5,S1\n"
+        "PM2.5,,S1\n"   // no AQI: counts as a row, not as a value
+        "NO2,7,S3\n"
+        "OZONE,15,S2\n");
+    DataProcessor data(path);
+    assert(data.LoadDataset() && data.GetTotalRows() == 6);
+
+    mini2::Aggregation spec;
+    spec.add_group_by("Parameter");
+    for (auto func : {mini2::Aggregation::COUNT, mini2::Aggregation::SUM, mini2::Aggregation::MIN,
+                      mini2::Aggregation::MAX, mini2::Aggregation::AVG}) {
+        auto* m = spec.add_measures();
+        m->set_func(func);
+        m->set_column("AQI");
+    }
+
+    // Three partials, as three workers would send them; OZONE and NO2 are
+    // missing from some, and PM2.5's second partial has no AQI values
+    auto partial = [&](size_t start, size_t count) {
+        Aggregator aggregator;
+        std::string error;
+        assert(aggregator.Compile(spec, data, &error));
+        aggregator.AccumulateChunk(data.GetChunk(start, count), RowFilter());
+        mini2::AggregateState state;
+        aggregator.ToState(&state);
+        return state;
+    };
+    const std::vector<mini2::AggregateState> parts = {partial(0, 2), partial(2, 2), partial(4, 2)};
+
+    mini2::AggregateState forward, backward;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        Aggregator::Merge(parts[i], &forward);
+        Aggregator::Merge(parts[parts.size() - 1 - i], &backward);
+    }
+    const mini2::AggregateState whole = partial(0, 6);
+    assert(Aggregator::Render(spec, forward) == Aggregator::Render(spec, whole));
+    assert(Aggregator::Render(spec, backward) == Aggregator::Render(spec, whole));
+
+    std::map<std::string, const mini2::AggregateState::Group*> groups;
+    for (const auto& g : forward.groups()) groups[g.keys(0)] = &g;
+    assert(groups.size() == 3);
+    // {rows, sum, min, max, values} per group; measure 1 is SUM(AQI)
+    struct Expected { uint64_t rows; double sum, min, max; uint64_t count; };
+    const std::map<std::string, Expected> expected = {
+        {"PM2.5", {3, 40, 10, 30, 2}},
+        {"OZONE", {2, 20, 5, 15, 2}},
+        {"NO2", {1, 7, 7, 7, 1}},
+    };
+    for (const auto& [key, e] : expected) {
+        const auto& g = *groups.at(key);
+        assert(g.rows() == e.rows);
+        for (int i = 1; i < spec.measures_size(); ++i) {
+            assert(g.sum(i) == e.sum && g.min(i) == e.min && g.max(i) == e.max && g.count(i) == e.count);
+        }
+        assert(g.sum(4) / g.count(4) == e.sum / e.count);  // AVG stays exact
+    }
+    std::filesystem::remove(path);
+}
+
+static void TestAggregatorPaths() {
+    // Empty and malformed values are skipped the same way whether measures
+    // are read from typed columns or parsed from the row
+    const std::string path = WriteTempFile("mini2_agg_paths.csv",
+        "UTC,Parameter,AQI,Site Name\n"
+        "1/2/20 10:00,PM2.5,10,\"say \"\"hi\"\", ok\"\n"
+        "bad,PM2.5,,\"say \"\"hi\"\", ok\"\n"
+        ",PM2.5,x,plain\n"
+        "1/1/1970 0:00,OZONE,0,plain\n"
+        "1/3/20 10:00,OZONE,30,plain\n");
+    mini2::Aggregation spec;
+    spec.add_group_by("Site Name");
+    for (auto func : {mini2::Aggregation::COUNT, mini2::Aggregation::MIN, mini2::Aggregation::AVG,
+                      mini2::Aggregation::SUM}) {
+        auto* m = spec.add_measures();
+        m->set_func(func);
+        m->set_column(func == mini2::Aggregation::SUM ? "AQI" : "UTC");
+    }
+
+    std::vector<std::string> rendered;
+    for (bool columns : {false, true}) {
+        DataProcessor data(path);
+        data.EnableColumnStore(columns);
+        assert(data.LoadDataset() && data.GetTotalRows() == 5);
+        const ColumnStore* store = data.GetColumnStore();
+        assert((store && store->Find(data.GetSchema().Find("UTC")->index)) == columns);
+
+        Aggregator aggregator;
+        assert(aggregator.Compile(spec, data, nullptr));
+        aggregator.AccumulateChunk(data.GetChunk(0, 5), RowFilter());
+        mini2::AggregateState state;
+        aggregator.ToState(&state);
+        std::map<std::string, const mini2::AggregateState::Group*> groups;
+        for (const auto& g : state.groups()) groups[g.keys(0)] = &g;
+
+        // "bad" and "" are not timestamps, "" and "x" not AQI values; the
+        // epoch itself is a real value
+        const auto& quoted = *groups.at("say \"\"hi\"\", ok");
+        assert(quoted.rows() == 2 && quoted.count(1) == 1 && quoted.count(3) == 1);
+        const auto& plain = *groups.at("plain");
+        assert(plain.rows() == 3 && plain.count(1) == 2 && plain.min(1) == 0);
+        assert(plain.count(3) == 2 && plain.sum(3) == 30);
+
+        rendered.push_back(Aggregator::Render(spec, state));
+    }
+    assert(rendered[0] == rendered[1]);
+    // Group keys are written back as valid CSV
+    assert(rendered[0].find("\n\"say \"\"hi\"\", ok\",2,") != std::string::npos);
+    std::filesystem::remove(path);
+}
+
+static void TestColumnBatch() {
+    using colbatch::Type;
+    colbatch::Writer writer({{"i32", Type::Int32}, {"i64", Type::Int64}, {"f64", Type::Float64},
+                             {"dict", Type::Dictionary}, {"str", Type::String}});
+    writer.AppendRow({"-7", "9000000000", "57.067140", "PM2.5", "Fresno, CA"});
+    writer.AppendRow({"", "x", "", "OZONE", ""});             // nulls (text is never null)
+    writer.AppendRow({"3000000000", "-1", "-0.5", "PM2.5", "say \"hi\""});  // too big for int32
+    const std::string batch = writer.Finish();
+    assert(batch.size() == writer.SerializedSize());
+    assert(colbatch::IsColumnBatch(batch));
+
+    colbatch::Reader reader;
+    std::string error;
+    assert(reader.Parse(batch, &error));
+    assert(reader.NumRows() == 3 && reader.NumColumns() == 5);
+    for (size_t c = 0; c < 5; ++c) {
+        assert(reader.FieldAt(c).type == static_cast<Type>(c + 1));
+    }
+    assert(reader.Int(0, 0) == -7 && reader.Int(1, 0) == 9000000000LL);
+    assert(reader.Double(2, 0) == 57.06714 && reader.Double(2, 2) == -0.5);
+    assert(reader.Text(3, 0) == "PM2.5" && reader.Text(3, 1) == "OZONE" && reader.Text(3, 2) == "PM2.5");
+    assert(reader.Text(4, 0) == "Fresno, CA" && reader.Text(4, 1).empty());
+    assert(reader.IsNull(0, 1) && reader.IsNull(1, 1) && reader.IsNull(2, 1));
+    assert(reader.IsNull(0, 2) && !reader.IsNull(1, 2));
+    assert(reader.ToCsv() ==
+           "i32,i64,f64,dict,str\n"
+           "-7,9000000000,57.06714,PM2.5,\"Fresno, CA\"\n"
+           ",,,OZONE,\n"
+           ",-1,-0.5,PM2.5,\"say \"hi\"\"\n");
+
+    // Every truncation is rejected
+    for (size_t len = 0; len < batch.size(); ++len) {
+        assert(!reader.Parse(std::string_view(batch.data(), len), &error));
+    }
+
+    // String offsets running backwards or past the data. The str column is
+    // last: its offsets sit just before the text bytes at the end.
+    const size_t text_bytes = std::strlen("Fresno, CA") + std::strlen("say \"hi\"");
+    const size_t offsets_at = batch.size() - text_bytes - 4 * sizeof(uint32_t);
+    std::string corrupt = batch;
+    uint32_t backwards = 20;  // offsets[1] > offsets[2]
+    std::memcpy(&corrupt[offsets_at + sizeof(uint32_t)], &backwards, sizeof(backwards));
+    assert(!reader.Parse(corrupt, &error));
+    corrupt = batch;
+    uint32_t past_end = 1000;
+    std::memcpy(&corrupt[offsets_at + 3 * sizeof(uint32_t)], &past_end, sizeof(past_end));
+    assert(!reader.Parse(corrupt, &error));
+
+    // Bad magic, version and column type
+    corrupt = batch;
+    corrupt[0] = 'X';
+    assert(!reader.Parse(corrupt, &error));
+    corrupt = batch;
+    corrupt[4] = 9;
+    assert(!reader.Parse(corrupt, &error));
+    corrupt = batch;
+    corrupt[4 + 1 + 4 + 4 + 2 + 3] = 42;  // type byte of the first column
+    assert(!reader.Parse(corrupt, &error));
+    assert(!reader.Parse("a,b\n1,2\n", &error));
+}
+
+static void TestGetNextCancel() {
+    SessionManager sessions;
+    const std::string id = sessions.CreateSession(mini2::Request());
+    assert(sessions.HasSession(id) && !sessions.HasSession("no-such-session"));
+
+    // A waiting GetNext gives up soon after its caller is cancelled
+    std::atomic<bool> cancel{false};
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        cancel = true;
+    });
+    auto start = std::chrono::steady_clock::now();
+    mini2::NextChunkResp resp;
+    assert(!sessions.GetNextChunk(id, 0, &resp, 1, [&cancel]() { return cancel.load(); }));
+    assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+    canceller.join();
+
+    assert(!sessions.GetNextChunk("no-such-session", 0, &resp));
+}
+
+static mini2::WorkerResult MakePart(uint32_t index, size_t bytes, char fill = 'x') {
+    mini2::WorkerResult part;
+    part.set_part_index(index);
+    part.set_payload(std::string(bytes, fill));
+    return part;
+}
+
+static void TestSessionBudgets() {
+    SessionManager sessions;
+    sessions.SetBudgets(1000, 1500);
+    sessions.SetReadAhead(0);
+    const std::string a = sessions.CreateSession(mini2::Request());
+    const std::string b = sessions.CreateSession(mini2::Request());
+    mini2::NextChunkResp resp;
+
+    // Over the per-session budget the producer waits until the client reads
+    assert(sessions.AddChunk(a, MakePart(0, 600)));
+    std::atomic<bool> added{false};
+    std::thread producer([&]() {
+        assert(sessions.AddChunk(a, MakePart(1, 600)));
+        added = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    assert(!added && sessions.GetBufferedBytes() == 600);
+    assert(sessions.GetNextChunk(a, 0, &resp) && resp.chunk().size() == 600);
+    assert(!added);
+    // Asking for chunk 1 releases chunk 0, which lets the producer add chunk 1
+    assert(sessions.GetNextChunk(a, 1, &resp) && resp.chunk().size() == 600);
+    producer.join();
+    assert(added && sessions.GetBufferedBytes() == 600);
+
+    // Within its own budget, b still waits on the node-wide one (a holds 600)
+    assert(sessions.AddChunk(b, MakePart(0, 500)));
+    added = false;
+    producer = std::thread([&]() {
+        assert(sessions.AddChunk(b, MakePart(1, 450)));
+        added = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    assert(!added && sessions.GetBufferedBytes() == 1100);
+    sessions.CompleteSession(a);
+    assert(!sessions.GetNextChunk(a, 2, &resp));  // releases a's chunk 1, then ends
+    producer.join();
+    assert(added && sessions.GetBufferedBytes() == 950);
+
+    // Cleanup returns everything to the node
+    sessions.CleanupSession(a);
+    sessions.CleanupSession(b);
+    assert(sessions.GetBufferedBytes() == 0);
+
+    // Producers of different sessions racing for the node-wide room can't
+    // all take it: 400 buffered, room for two more 400-byte chunks
+    std::vector<std::string> ids;
+    for (int i = 0; i < 4; ++i) {
+        ids.push_back(sessions.CreateSession(mini2::Request()));
+        assert(sessions.AddChunk(ids.back(), MakePart(0, 100)));
+    }
+    std::atomic<int> accepted{0};
+    std::vector<std::thread> producers;
+    for (const std::string& id : ids) {
+        producers.emplace_back([&, id]() {
+            if (sessions.AddChunk(id, MakePart(1, 400))) {
+                accepted++;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    assert(accepted == 2 && sessions.GetBufferedBytes() == 1200);
+    for (const std::string& id : ids) {
+        sessions.CleanupSession(id);
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    assert(sessions.GetBufferedBytes() == 0);
+}
+
+static std::string RandomBytes(std::mt19937& rng, size_t size) {
+    std::string bytes(size, '\0');
+    for (char& c : bytes) c = static_cast<char>(rng());
+    return bytes;
+}
+
+static void TestSpill() {
+    const std::string dir = std::filesystem::temp_directory_path().string();
+    std::mt19937 rng(11);
+
+    // Appends past the current mapping read back byte for byte, old and new
+    std::string error;
+    auto segment = SpillSegment::Create(dir, &error);
+    assert(segment && error.empty());
+    assert(!SpillSegment::Create(dir + "/mini2-no-such-dir", &error) && !error.empty());
+    std::vector<std::string> blobs;
+    std::vector<uint64_t> offsets;
+    for (size_t size : {100u, 4096u, 3u << 20, 5000u, 2u << 20, 1u}) {
+        blobs.push_back(RandomBytes(rng, size));
+        offsets.emplace_back();
+        assert(segment->Append(blobs.back(), &offsets.back()));
+        for (size_t i = 0; i < blobs.size(); ++i) {
+            std::string out;
+            assert(segment->Read(offsets[i], blobs[i].size(), &out) && out == blobs[i]);
+        }
+    }
+    std::string out;
+    assert(!segment->Read(segment->Size() - 1, 2, &out));
+#ifdef __linux__
+    // A discarded range no longer takes up disk
+    const uint64_t before = segment->DiskBytes();
+    segment->Discard(offsets[2], blobs[2].size());
+    assert(segment->DiskBytes() + (2u << 20) < before);
+    assert(segment->Read(offsets[4], blobs[4].size(), &out) && out == blobs[4]);
+#endif
+
+    // Past the watermark a session's chunks go to disk and come back intact;
+    // chunks the client has moved past leave the segment
+    SessionManager sessions;
+    sessions.SetSpill(dir, 1000);
+    sessions.SetReadAhead(0);
+    const std::string id = sessions.CreateSession(mini2::Request());
+    std::vector<std::string> payloads;
+    for (size_t size : {800u, 300000u, 70000u, 1u << 20}) {
+        payloads.push_back(RandomBytes(rng, size));
+        mini2::WorkerResult part;
+        part.set_part_index(static_cast<uint32_t>(payloads.size() - 1));
+        part.set_payload(payloads.back());
+        assert(sessions.AddChunk(id, std::move(part)));
+    }
+    sessions.CompleteSession(id);
+    assert(sessions.GetBufferedBytes() == 800);
+    assert(sessions.GetSpilledBytes() == 300000 + 70000 + (1u << 20));
+    mini2::NextChunkResp resp;
+    for (uint32_t i = 0; i < payloads.size(); ++i) {
+        assert(sessions.GetNextChunk(id, i, &resp) && resp.chunk() == payloads[i]);
+    }
+    assert(sessions.GetBufferedBytes() == 0 && sessions.GetSpilledBytes() == (1u << 20));
+    sessions.CleanupSession(id);
+    assert(sessions.GetSpilledBytes() == 0);
+}
+
+static void TestGetNextWindow() {
+    SessionManager sessions;
+    sessions.SetReadAhead(0);
+    const std::string id = sessions.CreateSession(mini2::Request());
+    for (uint32_t i = 0; i < 8; ++i) {
+        assert(sessions.AddChunk(id, MakePart(i, 100, static_cast<char>('a' + i))));
+    }
+    sessions.CompleteSession(id);
+    mini2::NextChunkResp resp;
+
+    // With 3 requests in flight, asking for 5 means 3 and 4 may still be on
+    // their way, so only 0..2 are released
+    assert(sessions.GetNextChunk(id, 5, &resp, 3) && resp.chunk() == std::string(100, 'f'));
+    assert(sessions.GetBufferedBytes() == 5 * 100);
+    assert(sessions.GetNextChunk(id, 3, &resp, 3) && resp.chunk() == std::string(100, 'd'));
+    assert(!sessions.GetNextChunk(id, 2, &resp, 3));  // already released
+
+    // The default window of one releases everything before the index
+    assert(sessions.GetNextChunk(id, 4, &resp) && resp.chunk() == std::string(100, 'e'));
+    assert(!sessions.GetNextChunk(id, 3, &resp));
+    assert(sessions.GetBufferedBytes() == 4 * 100);
+    sessions.CleanupSession(id);
+
+    // A session completed with an error hands it out on the final response
+    const std::string failed = sessions.CreateSession(mini2::Request());
+    assert(sessions.AddChunk(failed, MakePart(0, 10)));
+    sessions.CompleteSession(failed, "bad query: unknown column 'x'");
+    assert(sessions.GetNextChunk(failed, 0, &resp) && !resp.has_more());
+    assert(resp.error() == "bad query: unknown column 'x'");
+    mini2::NextChunkResp past_end;
+    assert(!sessions.GetNextChunk(failed, 1, &past_end) && past_end.error() == resp.error());
+    sessions.CleanupSession(failed);
+}
+
+// Handlers block on this until it is opened
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return open; });
+    }
+    void Open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = true;
+        cv.notify_all();
+    }
+};
+
+static void TestWorkerQueue() {
+    mini2::Request req;
+    req.set_request_id("q");
+
+    {
+        // With the only thread busy, exactly max_queue of many concurrent
+        // submissions are accepted; the rest are turned away
+        WorkerQueue queue("T", 1, 8);
+        queue.Start();
+        Gate gate, started;
+        assert(queue.EnqueueRequest(req, [&](const mini2::Request&) { started.Open(); gate.Wait(); }));
+        started.Wait();
+
+        std::atomic<int> accepted{0};
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 8; ++t) {
+            submitters.emplace_back([&]() {
+                for (int i = 0; i < 50; ++i) {
+                    if (queue.EnqueueRequest(req, [](const mini2::Request&) {})) accepted++;
+                }
+            });
+        }
+        for (auto& t : submitters) t.join();
+        assert(accepted == 8 && queue.GetQueueSize() == 8);
+        assert(queue.GetRejectedCount() == 8 * 50 - 8);
+
+        // The ingress service turns a full queue into RESOURCE_EXHAUSTED
+        auto processor = std::make_shared<RequestProcessor>("C");
+        auto shared_queue = std::shared_ptr<WorkerQueue>(&queue, [](WorkerQueue*) {});
+        TeamIngressService service(processor, shared_queue, "C");
+        mini2::HeartbeatAck ack;
+        grpc::Status status = service.HandleRequest(nullptr, &req, &ack);
+        assert(status.error_code() == grpc::StatusCode::RESOURCE_EXHAUSTED && !ack.ok());
+
+        gate.Open();
+        queue.Stop();
+        assert(queue.GetProcessedCount() == 1 + 8);
+    }
+
+    {
+        // Stop drains everything that was accepted
+        WorkerQueue queue("T", 2, 1000);
+        queue.Start();
+        std::atomic<int> ran{0};
+        int accepted = 0;
+        for (int i = 0; i < 200; ++i) {
+            accepted += queue.EnqueueRequest(req, [&ran](const mini2::Request&) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                ran++;
+            }) ? 1 : 0;
+        }
+        queue.Stop();
+        assert(accepted == 200 && ran == 200 && queue.IsIdle());
+        assert(!queue.EnqueueRequest(req, [](const mini2::Request&) {}));
+    }
+
+    for (int round = 0; round < 20; ++round) {
+        // Requests racing a Stop are either rejected or run, never lost
+        WorkerQueue queue("T", 2, 100000);
+        queue.Start();
+        std::atomic<int> accepted{0}, ran{0};
+        std::vector<std::thread> submitters;
+        for (int t = 0; t < 4; ++t) {
+            submitters.emplace_back([&]() {
+                for (int i = 0; i < 500; ++i) {
+                    if (queue.EnqueueRequest(req, [&ran](const mini2::Request&) { ran++; })) accepted++;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100 * round));
+        queue.Stop();
+        for (auto& t : submitters) t.join();
+        assert(ran == accepted && accepted + queue.GetRejectedCount() == 4 * 500);
+    }
+
+    {
+        // Work submitted from a handler lands in that thread's lane; idle
+        // threads steal it instead of leaving it to the busy one
+        WorkerQueue queue("T", 4, 1000);
+        queue.Start();
+        std::mutex ids_mutex;
+        std::set<std::thread::id> ids;
+        std::atomic<int> ran{0};
+        Gate done;
+        assert(queue.EnqueueRequest(req, [&](const mini2::Request&) {
+            for (int i = 0; i < 40; ++i) {
+                queue.EnqueueRequest(req, [&](const mini2::Request&) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    {
+                        std::lock_guard<std::mutex> lock(ids_mutex);
+                        ids.insert(std::this_thread::get_id());
+                    }
+                    if (++ran == 40) done.Open();
+                });
+            }
+        }));
+        done.Wait();
+        queue.Stop();
+        assert(queue.GetStolenCount() > 0 && ids.size() > 1);
+    }
+}
+
+int main(){
+    TestConfig();
+    TestCsvScanner();
+    TestRowFilter();
+    TestAggregatorMerge();
+    TestAggregatorPaths();
+    TestColumnBatch();
+    TestGetNextCancel();
+    TestSessionBudgets();
+    TestSpill();
+    TestGetNextWindow();
+    TestWorkerQueue();
+    std::cout << "cpp_unit_tests: all passed (scanner=" << csv::ScannerIsa() << ")" << std::endl;
     return 0;
 }